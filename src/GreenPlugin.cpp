@@ -29,7 +29,13 @@
 #include "SimulationCore.h"
  
 GreenPlugin::GreenPlugin(const string _name):
-	Plugin(_name)
+	Plugin(_name),
+	func_get_symmetry(NULL),
+	func_spectrum(NULL),
+	func_value_array_r(NULL),
+	func_row(NULL),
+	func_new_workspace(NULL),
+	func_free_workspace(NULL)
 {
 
 }
@@ -53,6 +59,36 @@ void GreenPlugin::load( const string new_path ) throw (FileNotFound, LibHandleEr
   if( func_value_array == NULL ){
     	throw (LibHandleError (dlerror() ) );
   }
+
+  //optional ... symmetry of the green's function, NULL if not exported
+  func_get_symmetry = (symmetry_t) dlsym( LibHandle, "get_symmetry");
+  if( func_get_symmetry == NULL ){
+    	dlerror();
+  }
+
+  //optional ... spectrum of the green's function, NULL if not exported
+  func_spectrum = (green_spectrum_function) dlsym( LibHandle, "get_spectrum_at");
+  if( func_spectrum == NULL ){
+    	dlerror();
+  }
+
+  //optional ... reentrant evaluation with a workspace per thread, NULL if not exported
+  func_value_array_r = (green_exec_r_function) dlsym( LibHandle, "get_value_at_r");
+  if( func_value_array_r == NULL ){
+    	dlerror();
+  }
+  func_row = (green_row_function) dlsym( LibHandle, "get_row_at");
+  if( func_row == NULL ){
+    	dlerror();
+  }
+  func_new_workspace = (green_workspace_function) dlsym( LibHandle, "new_workspace");
+  if( func_new_workspace == NULL ){
+    	dlerror();
+  }
+  func_free_workspace = (green_workspace_free_function) dlsym( LibHandle, "free_workspace");
+  if( func_free_workspace == NULL ){
+    	dlerror();
+  }
 }
 
 /*								*/
@@ -66,6 +102,84 @@ int GreenPlugin::getValueArrayAt(double **result, int x, int y)
 }
 
 
+/*								*/
+/* Does the plug-in export get_value_at_r()?			*/
+/*								*/
+bool GreenPlugin::isReentrant()
+{ 
+  return func_value_array_r != NULL;
+}
+
+/*								*/
+/* Workspace for get_value_at_r(), NULL if the plug-in needs none */
+/*								*/
+void* GreenPlugin::newWorkspace()
+{ 
+  assert(is_initialized);
+  return func_new_workspace == NULL ? NULL : func_new_workspace();
+}
+
+void GreenPlugin::freeWorkspace(void *workspace)
+{ 
+  if( func_free_workspace != NULL ){
+    	func_free_workspace(workspace);
+  }
+}
+
+/*								*/
+/* Reentrant evaluation in the given quadrant, see crusde_get_green_at_r() */
+/*								*/
+int GreenPlugin::getValueArrayAt(void *workspace, double **result, int x, int y, int quadrant)
+{ 
+  assert(is_initialized && func_value_array_r != NULL);
+  return func_value_array_r(workspace, result, x, y, quadrant);
+}
+
+/*								*/
+/* Does the plug-in export get_row_at()?				*/
+/*								*/
+bool GreenPlugin::hasRow()
+{ 
+  return func_row != NULL;
+}
+
+/*								*/
+/* n values along a row in the given quadrant, see crusde_get_green_row_at() */
+/*								*/
+int GreenPlugin::getRowAt(void *workspace, double **row, int x, int y, int n, int quadrant)
+{ 
+  assert(is_initialized && func_row != NULL);
+  return func_row(workspace, row, x, y, n, quadrant);
+}
+
+/*								*/
+/* Symmetry the plug-in declares, NO_SYMMETRY if none		*/
+/*								*/
+GreenSymmetry GreenPlugin::getSymmetry()
+{ 
+  if( func_get_symmetry == NULL ){
+    	return NO_SYMMETRY;
+  }
+  return func_get_symmetry();
+}
+
+/*								*/
+/* Does the plug-in export get_spectrum_at()?			*/
+/*								*/
+bool GreenPlugin::hasSpectrum()
+{ 
+  return func_spectrum != NULL;
+}
+
+/*								*/
+/* Spectrum at wavenumber (kx,ky), see crusde_get_green_spectrum_at() */
+/*								*/
+int GreenPlugin::getSpectrumAt(double **real, double **imag, double kx, double ky, double radius)
+{ 
+  assert(is_initialized && func_spectrum != NULL);
+  return func_spectrum(real, imag, kx, ky, radius);
+}
+
 /*								*/
 /* return pointer to exec function				*/
 /*								*/
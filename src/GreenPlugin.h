@@ -38,12 +38,20 @@
 
 using namespace std;
 
+typedef GreenSymmetry (*symmetry_t)();
+
 class GreenPlugin : public Plugin
 {
 
 	private:
         map<string, string> my_jobs;
 		green_exec_function func_value_array;		/*  Pointer to loaded routine	*/
+		symmetry_t func_get_symmetry;			/*  optional, NULL if the plug-in declares no symmetry */
+		green_spectrum_function func_spectrum;		/*  optional, NULL if the plug-in has no spectrum */
+		green_exec_r_function func_value_array_r;	/*  optional, NULL if the plug-in has no reentrant get_value_at_r() */
+		green_row_function func_row;			/*  optional, NULL if the plug-in has no get_row_at() */
+		green_workspace_function func_new_workspace;	/*  optional, NULL if get_value_at_r() needs no workspace */
+		green_workspace_free_function func_free_workspace;
 		/**hidden copy constructor - we do not want to accidentially copy objects*/
 		GreenPlugin(const GreenPlugin& x); 
 
@@ -56,6 +64,15 @@ class GreenPlugin : public Plugin
 		
 		/*plug - in interface*/
 		int getValueArrayAt(double**, int, int);
+		bool isReentrant();
+		void* newWorkspace();
+		void freeWorkspace(void*);
+		int getValueArrayAt(void*, double**, int, int, int);
+		bool hasRow();
+		int getRowAt(void*, double**, int, int, int, int);
+		GreenSymmetry getSymmetry();
+		bool hasSpectrum();
+		int getSpectrumAt(double**, double**, double, double, double);
 		/*get pointers to exec function*/
 		green_exec_function getArrayFunction();
 };
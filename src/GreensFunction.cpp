@@ -27,21 +27,79 @@
 
 #include "GreensFunction.h"
 #include "SimulationCore.h"
+#include "ParamWrapper.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* layout of a cache file: header, key, padding to 8 bytes, values */
+struct GreenCacheHeader {
+	char magic[8];
+	int  nx;
+	int  ny;
+	int  dims;
+	int  key_length;
+};
+
+static const char GREEN_CACHE_MAGIC[8] = { 'C','R','G','R','E','E','N','1' };
+
+static size_t green_cache_offset(size_t key_length)
+{
+	return (sizeof(GreenCacheHeader) + key_length + 7) / 8 * 8;
+}
 
 /* class GreensFunction */
 
 GreensFunction::GreensFunction(const string _name) : Plugin(_name),
 	map_iter(),
-	pl_green_map()
+	pl_green_map(),
+	pl_plugin_map(),
+	component(-1),
+	component_value(),
+	component_imag(),
+	p_profile_tolerance(NULL),
+	profile_function(),
+	profile_step(-1),
+	profile_direct(2),
+	profile_checked(0),
+	profile_z(),
+	profile_r(),
+	profile_value(NULL),
+	p_cache(NULL),
+	cache_key(),
+	cache_file(),
+	cache_function(),
+	cache_step(-1),
+	cache_nx(-1),
+	cache_ny(-1),
+	cache_dims(0),
+	cache_values(NULL),
+	cache_map(NULL),
+	cache_map_size(0),
+	cache_dirty(false)
 {}
 
 GreensFunction::~GreensFunction()
 {
-	map_iter = pl_green_map.begin();
+	flushCache();
+	delete [] profile_value;
+
+	map<string, GreenPlugin*>::iterator  plugin_iter = pl_plugin_map.begin();
 	
-	while(map_iter != pl_green_map.end() ){	
-		delete map_iter->second;
-		++map_iter;
+	while(plugin_iter != pl_plugin_map.end() ){	
+		delete plugin_iter->second;
+		++plugin_iter;
 	}
 }
 
@@ -51,24 +109,725 @@ GreensFunction::~GreensFunction()
 int GreensFunction::getValueArrayAt(double** d, int x, int y)
 { 
 	//NOTE: map_iter points to the job we are currently working with
-	return (map_iter->second)->getValueArrayAt(d,x,y);
+	if( p_profile_tolerance == NULL || *p_profile_tolerance <= 0.0 || getSymmetry() != AXIAL_SYMMETRY ){
+		return pluginValueAt(d,x,y);
+	}
+
+	//the profile is only valid for the job and model step it was sampled for
+	if( profile_function != pluginName() || profile_step != SimulationCore::instance()->modelStep() ){
+		resetProfile();
+	}
+
+	double r = sqrt( (double) x*x + (double) y*y );
+
+	int error = extendProfile( (int) r + 2 );
+	if( error != NOERROR ){
+		return error;
+	}
+
+	if( r < profile_direct ){
+		return pluginValueAt(d,x,y);
+	}
+
+	interpolateProfile(*d, r, abs(x), abs(y));
+	return NOERROR;
+}
+
+/*								*/
+/* Start a new profile for the current job and model step	*/
+/*								*/
+void GreensFunction::resetProfile()
+{
+	SimulationCore *core = SimulationCore::instance();
+
+	if( profile_value == NULL ){
+		profile_value = new double[core->getDimensions()];
+	}
+
+	profile_function     = pluginName();
+	profile_step    = core->modelStep();
+	profile_direct  = 2;
+	profile_checked = 0;
+	profile_z.clear();
+	profile_r.clear();
+
+	//cover the region of interest in one go, the points outside are added on demand
+	extendProfile( (int) sqrt( (double) core->sizeX()*core->sizeX() + (double) core->sizeY()*core->sizeY() ) + 2 );
+
+	crusde_info("Green's function '%s': radial profile of %d samples, plug-in called directly within %d grid cells", 
+	            profile_function.c_str(), (int) profile_z.size(), profile_direct);
+}
+
+/*								*/
+/* Sample the profile up to n grid cells			*/
+/*								*/
+/* The plug-in is called at (k,0) in quadrant 1, there x holds the radial displacement. 
+ * New samples are verified at the points (k,k) and (2k,k), whose radii fall between samples. 
+ * If an interpolated value deviates by more than profile_tolerance times the magnitude of the 
+ * samples it is interpolated from, everything up to that radius is evaluated by the plug-in 
+ * directly.
+ */
+int GreensFunction::extendProfile(int n)
+{
+	SimulationCore *core = SimulationCore::instance();
+	int quadrant = core->getQuadrant();
+	int x_index = core->xIndex();
+	int z_index = core->zIndex();
+	int index[3] = { x_index, core->yIndex(), z_index };
+	int i, k, ray, x, y, error = NOERROR;
+	double r, scale, deviation;
+	vector<double> interpolated( core->getDimensions() );
+
+	if( (int) profile_z.size() > n ){
+		return NOERROR;
+	}
+
+	core->setQuadrant(1);
+
+	for(k = profile_z.size(); k <= n && error == NOERROR; ++k){
+		error = pluginValueAt(&profile_value, k, 0);
+		profile_z.push_back( z_index < 0 ? 0.0 : profile_value[z_index] );
+		profile_r.push_back( x_index < 0 ? 0.0 : profile_value[x_index] );
+	}
+
+	//check points whose interpolation needs samples up to n
+	for(k = profile_checked+1; error == NOERROR && (int) (k*sqrt(5.0)) + 2 <= n; ++k){
+		profile_checked = k;
+
+		for(ray = 1; ray <= 2 && error == NOERROR; ++ray){
+			x = ray*k;
+			y = k;
+			r = sqrt( (double) x*x + (double) y*y );
+
+			if( r < profile_direct ){
+				continue;
+			}
+
+			error = pluginValueAt(&profile_value, x, y);
+			interpolateProfile(&interpolated[0], r, x, y);
+
+			scale = 0.0;
+			for(i = (int) r - 1; i <= (int) r + 2; ++i){
+				scale = max(scale, max(fabs(profile_z[i]), fabs(profile_r[i])));
+			}
+
+			deviation = 0.0;
+			for(i = 0; i < 3; ++i){
+				if( index[i] >= 0 ){
+					deviation = max(deviation, fabs(profile_value[index[i]] - interpolated[index[i]]));
+				}
+			}
+
+			if( deviation > *p_profile_tolerance * scale ){
+				profile_direct = (int) ceil(r) + 1;
+			}
+		}
+	}
+
+	core->setQuadrant(quadrant);
+
+	return error;
+}
+
+/*								*/
+/* Interpolated value at radius r (grid cells) of point (x,y) >= 0 */
+/*								*/
+/* Cubic (Catmull-Rom) interpolation of k*G(k), i.e. exact for a 1/r decay, with the samples 
+ * floor(r)-1 ... floor(r)+2. The radial displacement is projected onto x and y, the quadrant 
+ * gives the signs as in the plug-ins.
+ */
+void GreensFunction::interpolateProfile(double* value, double r, int x, int y)
+{
+	SimulationCore *core = SimulationCore::instance();
+	int quadrant = core->getQuadrant();
+	int i = (int) r;
+	double t = r - i;
+	double w[4] = { 0.5*(-t*t*t + 2.0*t*t - t),
+	                0.5*( 3.0*t*t*t - 5.0*t*t + 2.0),
+	                0.5*(-3.0*t*t*t + 4.0*t*t + t),
+	                0.5*( t*t*t - t*t) };
+	double z = 0.0, radial = 0.0;
+
+	for(int j = 0; j < 4; ++j){
+		z      += w[j] * (i-1+j) * profile_z[i-1+j];
+		radial += w[j] * (i-1+j) * profile_r[i-1+j];
+	}
+	z      /= r;
+	radial /= r;
+
+	if( core->zIndex() >= 0 ){
+		value[core->zIndex()] = z;
+	}
+	if( core->xIndex() >= 0 ){
+		value[core->xIndex()] = ( quadrant == 3 || quadrant == 4 ? -1.0 : 1.0 ) * radial * x / r;
+	}
+	if( core->yIndex() >= 0 ){
+		value[core->yIndex()] = ( quadrant == 2 || quadrant == 3 ? -1.0 : 1.0 ) * radial * y / r;
+	}
+}
+
+/*								*/
+/* Value of the current job at (x,y)				*/
+/*								*/
+/* The weighted sum of the job's plug-ins, or the selected component alone. */
+int GreensFunction::jobValueAt(double** d, int x, int y)
+{
+	vector<GreenComponent> &terms = map_iter->second;
+
+	if( component >= 0 ){
+		return terms[component].plugin->getValueArrayAt(d,x,y);
+	}
+	if( !isComposite() ){
+		return terms[0].plugin->getValueArrayAt(d,x,y);
+	}
+
+	int dims = SimulationCore::instance()->getDimensions();
+	int error;
+
+	component_value.resize(dims);
+	double *value = &component_value[0];
+
+	fill(*d, *d + dims, 0.0);
+
+	for(size_t i = 0; i < terms.size(); ++i){
+		fill(component_value.begin(), component_value.end(), 0.0);
+
+		error = terms[i].plugin->getValueArrayAt(&value,x,y);
+		if( error != NOERROR ){
+			return error;
+		}
+
+		for(int k = 0; k < dims; ++k){
+			(*d)[k] += terms[i].weight * value[k];
+		}
+	}
+
+	return NOERROR;
+}
+
+/*								*/
+/* Can the current job be evaluated by several threads at once? */
+/*								*/
+/* All plug-ins of the job (or the selected component) have to export get_value_at_r(), and 
+ * neither the radial profile nor the disk cache may be in use: both keep state in the core. 
+ */
+bool GreensFunction::isReentrant()
+{
+	GreenSymmetry symmetry = getSymmetry();
+
+	if( p_profile_tolerance != NULL && *p_profile_tolerance > 0.0 && symmetry == AXIAL_SYMMETRY ){
+		return false;
+	}
+	if( p_cache != NULL && strcmp(*p_cache, "on") == 0 && symmetry != NO_SYMMETRY ){
+		return false;
+	}
+
+	vector<GreenComponent> &terms = map_iter->second;
+
+	for(size_t i = 0; i < terms.size(); ++i){
+		if( (component < 0 || component == (int) i) && !terms[i].plugin->isReentrant() ){
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*								*/
+/* Workspace of one thread for getValueArrayAt(workspace, ...) */
+/*								*/
+/* Holds a workspace for each reentrant plug-in, i.e. it serves all jobs. Not reentrant itself, 
+ * operators create the workspaces before they start their threads. 
+ */
+GreenWorkspace* GreensFunction::newWorkspace()
+{
+	GreenWorkspace *workspace = new GreenWorkspace();
+	map<string, GreenPlugin*>::iterator plugin_iter = pl_plugin_map.begin();
+
+	while(plugin_iter != pl_plugin_map.end()){
+		if( (plugin_iter->second)->isReentrant() ){
+			workspace->plugin[plugin_iter->second] = (plugin_iter->second)->newWorkspace();
+		}
+		++plugin_iter;
+	}
+
+	workspace->value.resize( SimulationCore::instance()->getDimensions() );
+
+	return workspace;
+}
+
+void GreensFunction::freeWorkspace(GreenWorkspace *workspace)
+{
+	if( workspace == NULL ){
+		return;
+	}
+
+	map<GreenPlugin*, void*>::iterator iter = workspace->plugin.begin();
+
+	while(iter != workspace->plugin.end()){
+		(iter->first)->freeWorkspace(iter->second);
+		++iter;
+	}
+
+	delete workspace;
+}
+
+/*								*/
+/* Value of the current job at (x,y) in the given quadrant, reentrant */
+/*								*/
+/* As jobValueAt(), but each plug-in evaluates with its part of the workspace. Only valid if 
+ * isReentrant(); the job and the selected component must not change meanwhile. 
+ */
+int GreensFunction::getValueArrayAt(GreenWorkspace *workspace, double** d, int x, int y, int quadrant)
+{
+	vector<GreenComponent> &terms = map_iter->second;
+
+	if( component >= 0 ){
+		return terms[component].plugin->getValueArrayAt(workspace->plugin[terms[component].plugin], d, x, y, quadrant);
+	}
+	if( !isComposite() ){
+		return terms[0].plugin->getValueArrayAt(workspace->plugin[terms[0].plugin], d, x, y, quadrant);
+	}
+
+	int dims = workspace->value.size();
+	int error;
+	double *value = &workspace->value[0];
+
+	fill(*d, *d + dims, 0.0);
+
+	for(size_t i = 0; i < terms.size(); ++i){
+		fill(workspace->value.begin(), workspace->value.end(), 0.0);
+
+		error = terms[i].plugin->getValueArrayAt(workspace->plugin[terms[i].plugin], &value, x, y, quadrant);
+		if( error != NOERROR ){
+			return error;
+		}
+
+		for(int k = 0; k < dims; ++k){
+			(*d)[k] += terms[i].weight * value[k];
+		}
+	}
+
+	return NOERROR;
+}
+
+/*								*/
+/* Values of the current job at (x+i,y), 0 <= i < n, reentrant	*/
+/*								*/
+/* row[d][i] receives displacement dimension d of point x+i. The weighted sum of the job's 
+ * plug-ins, or the selected component alone; see getValueArrayAt(workspace, ...). 
+ */
+int GreensFunction::getRowAt(GreenWorkspace *workspace, double** row, int x, int y, int n, int quadrant)
+{
+	vector<GreenComponent> &terms = map_iter->second;
+
+	if( component >= 0 ){
+		return pluginRowAt(workspace, terms[component].plugin, row, x, y, n, quadrant);
+	}
+	if( !isComposite() ){
+		return pluginRowAt(workspace, terms[0].plugin, row, x, y, n, quadrant);
+	}
+
+	int dims = SimulationCore::instance()->displacementDimensions();
+	int error, d, i;
+
+	workspace->row.resize(dims*n);
+	workspace->row_pointer.resize(dims);
+	for(d = 0; d < dims; ++d){
+		workspace->row_pointer[d] = &workspace->row[d*n];
+		fill(row[d], row[d] + n, 0.0);
+	}
+
+	for(size_t k = 0; k < terms.size(); ++k){
+		error = pluginRowAt(workspace, terms[k].plugin, &workspace->row_pointer[0], x, y, n, quadrant);
+		if( error != NOERROR ){
+			return error;
+		}
+
+		for(d = 0; d < dims; ++d){
+			const double *part = workspace->row_pointer[d];
+			for(i = 0; i < n; ++i){
+				row[d][i] += terms[k].weight * part[i];
+			}
+		}
+	}
+
+	return NOERROR;
+}
+
+/*								*/
+/* Row of one plug-in, point by point if it has no get_row_at()	*/
+/*								*/
+int GreensFunction::pluginRowAt(GreenWorkspace *workspace, GreenPlugin *plugin, double** row, int x, int y, int n, int quadrant)
+{
+	void *plugin_workspace = workspace->plugin[plugin];
+
+	if( plugin->hasRow() ){
+		return plugin->getRowAt(plugin_workspace, row, x, y, n, quadrant);
+	}
+
+	int dims = SimulationCore::instance()->displacementDimensions();
+	int error;
+	double *value = &workspace->value[0];
+
+	for(int i = 0; i < n; ++i){
+		fill(workspace->value.begin(), workspace->value.end(), 0.0);
+
+		error = plugin->getValueArrayAt(plugin_workspace, &value, x+i, y, quadrant);
+		if( error != NOERROR ){
+			return error;
+		}
+
+		for(int d = 0; d < dims; ++d){
+			row[d][i] = value[d];
+		}
+	}
+
+	return NOERROR;
+}
+
+/*								*/
+/* Plug-in value at (x,y), from the disk cache if it is used	*/
+/*								*/
+/* The table holds the values of quadrant 1 at (|x|,|y|), missing ones are sampled there. The 
+ * quadrant the caller is in only flips the signs of the horizontal components.
+ */
+int GreensFunction::pluginValueAt(double** d, int x, int y)
+{
+	if( p_cache == NULL || strcmp(*p_cache, "on") != 0 || getSymmetry() == NO_SYMMETRY ){
+		return jobValueAt(d,x,y);
+	}
+
+	SimulationCore *core = SimulationCore::instance();
+	int quadrant = core->getQuadrant();
+	int ax = abs(x), ay = abs(y);
+	int error;
+	double *value;
+
+	if( cache_function != pluginName() || cache_step != core->modelStep() ){
+		openCache();
+	}
+
+	if( ax > cache_nx || ay > cache_ny ){
+		growCache( max(ax, cache_nx + cache_nx/2), max(ay, cache_ny + cache_ny/2) );
+	}
+
+	value = cache_values + ( (size_t) ax + (size_t) (cache_nx+1) * ay ) * cache_dims;
+
+	if( value[0] != value[0] ){
+		vector<double> sample(cache_dims, 0.0);
+		double *p_sample = &sample[0];
+
+		core->setQuadrant(1);
+		error = jobValueAt(&p_sample, ax, ay);
+		core->setQuadrant(quadrant);
+
+		if( error != NOERROR ){
+			return error;
+		}
+
+		copy(sample.begin(), sample.end(), value);
+		cache_dirty = true;
+	}
+
+	copy(value, value + cache_dims, *d);
+
+	if( core->xIndex() >= 0 && (quadrant == 3 || quadrant == 4) ){
+		(*d)[core->xIndex()] = -(*d)[core->xIndex()];
+	}
+	if( core->yIndex() >= 0 && (quadrant == 2 || quadrant == 3) ){
+		(*d)[core->yIndex()] = -(*d)[core->yIndex()];
+	}
+
+	return NOERROR;
+}
+
+/*								*/
+/* Open the cache table of the current job and model step	*/
+/*								*/
+/* The key lists plug-in name and version, grid size, model step, values per point and all 
+ * Green's function parameters but the ones of the core. It is stored in the file as well, 
+ * a file whose key differs (hash collision) is not used.
+ */
+void GreensFunction::openCache()
+{
+	SimulationCore *core = SimulationCore::instance();
+	multimap<string, ParamWrapper*>::iterator param;
+	ostringstream key, name;
+	uint64_t hash = 14695981039346656037ULL;	/* FNV-1a */
+	struct stat info;
+	string dir;
+	int fd;
+
+	flushCache();
+
+	cache_function  = pluginName();
+	cache_step = core->modelStep();
+	cache_dims = core->getDimensions();
+
+	key.precision(17);
+	key << "plugin=" << pluginName() << ";version=" << pluginVersion()
+	    << ";gridsize=" << core->gridSize() << ";step=" << cache_step << ";dimensions=" << cache_dims;
+
+	for(param = SimulationCore::s_params.green.begin(); param != SimulationCore::s_params.green.end(); ++param){
+		if( param->first == "green_cache" || param->first == "profile_tolerance" ){
+			continue;
+		}
+
+		key << ";" << param->first << "=";
+		if( param->second->isDouble() ){
+			key << *(param->second->doubleValue());
+		}
+		else if( param->second->isString() ){
+			key << *(param->second->stringValue());
+		}
+	}
+	cache_key = key.str();
+
+	for(size_t i = 0; i < cache_key.size(); ++i){
+		hash ^= (unsigned char) cache_key[i];
+		hash *= 1099511628211ULL;
+	}
+
+	name << hex << setw(16) << setfill('0') << hash;
+
+	dir = string(getenv("CRUSDE_HOME")).append("/cache");
+	if( (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) || 
+	    (mkdir(dir.append("/green").c_str(), 0755) != 0 && errno != EEXIST) ){
+		crusde_warning("Green's function cache: cannot create directory %s: %s, values are not stored", 
+		               dir.c_str(), strerror(errno));
+		cache_file.clear();
+	}
+	else{
+		cache_file = dir + "/" + name.str() + ".bin";
+	}
+
+	//map a matching table, its pages are private, i.e. new values do not go to the file directly
+	if( !cache_file.empty() && (fd = open(cache_file.c_str(), O_RDONLY)) >= 0 ){
+		if( fstat(fd, &info) == 0 && (size_t) info.st_size >= green_cache_offset(cache_key.size()) ){
+			void *map = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+			if( map != MAP_FAILED ){
+				GreenCacheHeader *header = (GreenCacheHeader*) map;
+				size_t offset = green_cache_offset(cache_key.size());
+
+				if( memcmp(header->magic, GREEN_CACHE_MAGIC, sizeof(GREEN_CACHE_MAGIC)) == 0 &&
+				    header->key_length == (int) cache_key.size() && header->dims == cache_dims &&
+				    header->nx >= 0 && header->ny >= 0 &&
+				    cache_key.compare(0, string::npos, (char*) map + sizeof(GreenCacheHeader), header->key_length) == 0 &&
+				    (size_t) info.st_size == offset + (size_t) (header->nx+1) * (header->ny+1) * cache_dims * sizeof(double) ){
+					cache_map      = map;
+					cache_map_size = info.st_size;
+					cache_values   = (double*) ((char*) map + offset);
+					cache_nx       = header->nx;
+					cache_ny       = header->ny;
+				}
+				else{
+					crusde_warning("Green's function cache: %s does not belong to this model, ignoring it", cache_file.c_str());
+					munmap(map, info.st_size);
+				}
+			}
+		}
+		close(fd);
+	}
+
+	if( cache_values == NULL ){
+		growCache( core->sizeX(), core->sizeY() );
+		crusde_info("Green's function '%s': new cache table %s", cache_function.c_str(), cache_file.c_str());
+	}
+	else{
+		crusde_info("Green's function '%s': using cache table %s", cache_function.c_str(), cache_file.c_str());
+	}
+}
+
+/*								*/
+/* Enlarge the table to 0 <= x <= nx, 0 <= y <= ny		*/
+/*								*/
+void GreensFunction::growCache(int nx, int ny)
+{
+	size_t row = (size_t) (nx+1) * cache_dims;
+	double *values = new double[row * (ny+1)];
+
+	fill(values, values + row * (ny+1), numeric_limits<double>::quiet_NaN());
+
+	for(int y = 0; y <= cache_ny; ++y){
+		copy(cache_values + (size_t) y * (cache_nx+1) * cache_dims, 
+		     cache_values + (size_t) (y+1) * (cache_nx+1) * cache_dims, 
+		     values + y * row);
+	}
+
+	if( cache_map != NULL ){
+		munmap(cache_map, cache_map_size);
+		cache_map = NULL;
+	}
+	else{
+		delete [] cache_values;
+	}
+
+	cache_values = values;
+	cache_nx     = nx;
+	cache_ny     = ny;
+}
+
+/*								*/
+/* Write the table if it has new values, then drop it		*/
+/*								*/
+/* The table goes to a temporary file first, which is then renamed. Concurrent runs thus 
+ * never see a partial table, the last one to finish wins.
+ */
+void GreensFunction::flushCache()
+{
+	if( cache_dirty && !cache_file.empty() ){
+		ostringstream temp;
+		GreenCacheHeader header;
+		vector<char> padding( green_cache_offset(cache_key.size()) - sizeof(header) - cache_key.size(), 0 );
+		size_t size = (size_t) (cache_nx+1) * (cache_ny+1) * cache_dims;
+		FILE *file;
+		bool written;
+
+		memcpy(header.magic, GREEN_CACHE_MAGIC, sizeof(header.magic));
+		header.nx         = cache_nx;
+		header.ny         = cache_ny;
+		header.dims       = cache_dims;
+		header.key_length = cache_key.size();
+
+		temp << cache_file << "." << getpid();
+
+		if( (file = fopen(temp.str().c_str(), "wb")) != NULL ){
+			written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+			          fwrite(cache_key.data(), 1, cache_key.size(), file) == cache_key.size() &&
+			          fwrite(&padding[0], 1, padding.size(), file) == padding.size() &&
+			          fwrite(cache_values, sizeof(double), size, file) == size;
+			written = (fclose(file) == 0) && written;
+
+			if( written && rename(temp.str().c_str(), cache_file.c_str()) == 0 ){
+				crusde_info("Green's function cache: wrote %s", cache_file.c_str());
+			}
+			else{
+				crusde_warning("Green's function cache: could not write %s", cache_file.c_str());
+				remove(temp.str().c_str());
+			}
+		}
+		else{
+			crusde_warning("Green's function cache: could not write %s: %s", temp.str().c_str(), strerror(errno));
+		}
+	}
+
+	if( cache_map != NULL ){
+		munmap(cache_map, cache_map_size);
+	}
+	else{
+		delete [] cache_values;
+	}
+
+	cache_values = NULL;
+	cache_map    = NULL;
+	cache_nx     = -1;
+	cache_ny     = -1;
+	cache_dirty  = false;
+	cache_function.clear();
+	cache_step   = -1;
+}
+
+/*								*/
+/* Symmetry declared by the Green's function of the current job */
+/*								*/
+/* A weighted sum has the symmetry all its components share.	*/
+GreenSymmetry GreensFunction::getSymmetry()
+{ 
+	vector<GreenComponent> &terms = map_iter->second;
+
+	if( component >= 0 ){
+		return terms[component].plugin->getSymmetry();
+	}
+
+	GreenSymmetry symmetry = terms[0].plugin->getSymmetry();
+
+	for(size_t i = 1; i < terms.size(); ++i){
+		symmetry = min(symmetry, terms[i].plugin->getSymmetry());
+	}
+
+	return symmetry;
+}
+
+/*								*/
+/* Do the Green's functions of all jobs provide a spectrum?	*/
+/*								*/
+bool GreensFunction::hasSpectrum()
+{ 
+	map<string, GreenPlugin*>::iterator  iter = pl_plugin_map.begin();
+
+	while(iter != pl_plugin_map.end()){
+		if( !(iter->second)->hasSpectrum() ){
+			return false;
+		}
+		++iter;
+	}
+
+	return !pl_plugin_map.empty();
+}
+
+/*								*/
+/* Spectrum of the Green's function of the current job		*/
+/*								*/
+/* The transform is linear, a weighted sum has the weighted sum of the spectra. */
+int GreensFunction::getSpectrumAt(double** real, double** imag, double kx, double ky, double radius)
+{ 
+	vector<GreenComponent> &terms = map_iter->second;
+
+	if( component >= 0 ){
+		return terms[component].plugin->getSpectrumAt(real, imag, kx, ky, radius);
+	}
+	if( !isComposite() ){
+		return terms[0].plugin->getSpectrumAt(real, imag, kx, ky, radius);
+	}
+
+	int dims = SimulationCore::instance()->getDimensions();
+	int error;
+
+	component_value.resize(dims);
+	component_imag.resize(dims);
+	double *re = &component_value[0];
+	double *im = &component_imag[0];
+
+	fill(*real, *real + dims, 0.0);
+	fill(*imag, *imag + dims, 0.0);
+
+	for(size_t i = 0; i < terms.size(); ++i){
+		fill(component_value.begin(), component_value.end(), 0.0);
+		fill(component_imag.begin(), component_imag.end(), 0.0);
+
+		error = terms[i].plugin->getSpectrumAt(&re, &im, kx, ky, radius);
+		if( error != NOERROR ){
+			return error;
+		}
+
+		for(int k = 0; k < dims; ++k){
+			(*real)[k] += terms[i].weight * re[k];
+			(*imag)[k] += terms[i].weight * im[k];
+		}
+	}
+
+	return NOERROR;
 }
 
 void GreensFunction::setFirstJob()
 {
 	map_iter = pl_green_map.begin();
+	component = -1;
 }    
 
 bool GreensFunction::nextJob()
 {
 	++map_iter;
+	component = -1;
 
 	return (map_iter == pl_green_map.end() ? false : true);
 }    
 
 bool GreensFunction::isLastJob()
 {
-	map<string, GreenPlugin*>::iterator  iter( map_iter );
+	map<string, vector<GreenComponent> >::iterator  iter( map_iter );
 	
 	if( (++iter) == pl_green_map.end()) 
 	{
@@ -80,99 +839,196 @@ bool GreensFunction::isLastJob()
 
 string GreensFunction::job()
 {
-	return map_iter->first.empty() ? map_iter->second->getName().append(" (no job name defined)") : map_iter->first;
+	return map_iter->first.empty() ? pluginName().append(" (no job name defined)") : map_iter->first;
 }    
 
+/*								*/
+/* Name of the plug-in of the current job			*/
+/*								*/
+/* The selected component's name, or for a weighted sum the list of weights and names, 
+ * e.g. "1*elastic halfspace (pinel) + 1*thick plate (pinel)". 
+ */
+string GreensFunction::pluginName()
+{
+	vector<GreenComponent> &terms = map_iter->second;
+
+	if( component >= 0 ){
+		return terms[component].plugin->getName();
+	}
+	if( !isComposite() ){
+		return terms[0].plugin->getName();
+	}
+
+	ostringstream name;
+
+	for(size_t i = 0; i < terms.size(); ++i){
+		name << (i > 0 ? " + " : "") << terms[i].weight << "*" << terms[i].plugin->getName();
+	}
+
+	return name.str();
+}
 
-void GreensFunction::load(map<string, string > job_map)
+/*								*/
+/* Version of the plug-in of the current job, as pluginName()	*/
+/*								*/
+string GreensFunction::pluginVersion()
 {
+	vector<GreenComponent> &terms = map_iter->second;
 
-	map<string, string>::iterator jobs_iter = job_map.begin();
+	if( component >= 0 ){
+		return terms[component].plugin->getVersion();
+	}
+
+	string version( terms[0].plugin->getVersion() );
+
+	for(size_t i = 1; i < terms.size(); ++i){
+		version.append("+").append( terms[i].plugin->getVersion() );
+	}
+
+	return version;
+}
+
+bool GreensFunction::isComposite()
+{
+	return map_iter->second.size() > 1 || map_iter->second[0].weight != 1.0;
+}
+
+/*								*/
+/* Number of plug-ins the current job is the weighted sum of	*/
+/*								*/
+int GreensFunction::components()
+{
+	return map_iter->second.size();
+}
+
+/*								*/
+/* Restrict the current job to one of its components		*/
+/*								*/
+/* Until the job changes or -1 is selected, values, spectrum, symmetry and plug-in name are 
+ * those of component i alone, without its weight. Returns the weight (1 for -1). 
+ */
+double GreensFunction::selectComponent(int i)
+{
+	if( i >= components() ){
+		crusde_error("Job '%s' has %d Green's functions, component %d requested.", job().c_str(), components(), i);
+	}
+
+	component = (i < 0 ? -1 : i);
+
+	return component < 0 ? 1.0 : map_iter->second[component].weight;
+}
+
+
+void GreensFunction::load(map<string, vector< pair<string, double> > > job_map)
+{
+
+	map<string, vector< pair<string, double> > >::iterator jobs_iter = job_map.begin();
 
 	if( job_map.size() == 1 && !(jobs_iter->first).empty() )
 		crusde_warning("Only one job definition given. I'll do it anyway - but you better double check!");
 
 	while(jobs_iter != job_map.end()){
-		GreenPlugin *pl_green = new GreenPlugin( (jobs_iter->second).c_str() );
+		vector< pair<string, double> >::iterator term = (jobs_iter->second).begin();
 
-		//try loading the plugins
-		try
-		{
-			pl_green->load( (jobs_iter->second).c_str());
-		}
-		catch(runtime_error e)
-		{
-			SimulationCore::instance()->abort(e.what());
+		while(term != (jobs_iter->second).end()){
+			//each plug-in is loaded once, jobs share it
+			map<string, GreenPlugin*>::iterator plugin_iter = pl_plugin_map.find(term->first);
+
+			if( plugin_iter == pl_plugin_map.end() ){
+				GreenPlugin *pl_green = new GreenPlugin( (term->first).c_str() );
+
+				//try loading the plugins
+				try
+				{
+					pl_green->load( (term->first).c_str());
+				}
+				catch(runtime_error e)
+				{
+					SimulationCore::instance()->abort(e.what());
+				}
+
+				plugin_iter = pl_plugin_map.insert(pair<string, GreenPlugin*> (term->first, pl_green) ).first;
+			}
+
+			GreenComponent entry = { plugin_iter->second, term->second };
+			pl_green_map[jobs_iter->first].push_back(entry);
+			++term;
 		}
-		
-		pl_green_map.insert(pair<string, GreenPlugin*> (jobs_iter->first, pl_green) );
+
 		++jobs_iter;
 	}    
 }
 
 void GreensFunction::unload() throw (LibHandleError)
 {
-	map_iter = pl_green_map.begin();
+	map<string, GreenPlugin*>::iterator plugin_iter = pl_plugin_map.begin();
 
-	while(map_iter != pl_green_map.end()){
+	while(plugin_iter != pl_plugin_map.end()){
 		//unload load plug-ins
-		(map_iter->second)->unload();
-		++map_iter;
+		(plugin_iter->second)->unload();
+		++plugin_iter;
 	}
 }    
 
 void GreensFunction::registerParameter()
 {
-	map_iter = pl_green_map.begin();
+	//relative accuracy of the radial profile of axisymmetric Green's functions, 0: not used
+	p_profile_tolerance = crusde_register_optional_param_double("profile_tolerance", GREEN_PLUGIN, 0.0);
+	//keep sampled values of symmetric Green's functions in $CRUSDE_HOME/cache/green, 'on' or 'off'
+	p_cache = crusde_register_optional_param_string("green_cache", GREEN_PLUGIN, (char*) "off");
+
+	map<string, GreenPlugin*>::iterator plugin_iter = pl_plugin_map.begin();
 	
-	while(map_iter != pl_green_map.end()){
+	while(plugin_iter != pl_plugin_map.end()){
 		//register parameter of load plug-ins
-		(map_iter->second)->registerParameter();
-		++map_iter;
+		(plugin_iter->second)->registerParameter();
+		++plugin_iter;
 	}
 }    
 
 void GreensFunction::registerOutputFields()
 {
-	map_iter = pl_green_map.begin();
+	map<string, GreenPlugin*>::iterator plugin_iter = pl_plugin_map.begin();
 	
-	while(map_iter != pl_green_map.end()){
+	while(plugin_iter != pl_plugin_map.end()){
 		//register additional memory
-		(map_iter->second)->registerOutputFields();
-		++map_iter;
+		(plugin_iter->second)->registerOutputFields();
+		++plugin_iter;
 	}
 }    
 
 void GreensFunction::requestPlugins()
 {
-	map_iter = pl_green_map.begin();
+	map<string, GreenPlugin*>::iterator plugin_iter = pl_plugin_map.begin();
 	
-	while(map_iter != pl_green_map.end()){
+	while(plugin_iter != pl_plugin_map.end()){
 		//Have plug-ins load their additional plug-ins 
-		(map_iter->second)->requestPlugins();
-		++map_iter;
+		(plugin_iter->second)->requestPlugins();
+		++plugin_iter;
 	}
 }    
 
 void GreensFunction::init()
 {
-	map_iter = pl_green_map.begin();
+	map<string, GreenPlugin*>::iterator plugin_iter = pl_plugin_map.begin();
 	
-	while(map_iter != pl_green_map.end()){
+	while(plugin_iter != pl_plugin_map.end()){
 		//Have plug-ins be initialized
-		(map_iter->second)->init();
-		++map_iter;
+		(plugin_iter->second)->init();
+		++plugin_iter;
 	}
 }    
 
 void GreensFunction::release()
 {
-	map_iter = pl_green_map.begin();
+	flushCache();
+
+	map<string, GreenPlugin*>::iterator plugin_iter = pl_plugin_map.begin();
 	
-	while(map_iter != pl_green_map.end()){
+	while(plugin_iter != pl_plugin_map.end()){
 		//Have plug-ins free their memory
-		(map_iter->second)->release();
-		++map_iter;
+		(plugin_iter->second)->release();
+		++plugin_iter;
 	}
 }    
 
@@ -36,6 +36,8 @@
 #include <cassert>
 #include <dlfcn.h>
 #include <map>
+#include <string>
+#include <vector>
 
 using namespace std;
 
@@ -47,13 +49,95 @@ using namespace std;
  *  since all the loads could and should have different parameter values 
  *  whereas the Green's functions are allowed to have only one identical 
  *  parameter set. 
+ *
+ *  Green's functions that declare AXIAL_SYMMETRY can be served from a radial 
+ *  profile: the plug-in is sampled on the x axis, one value per grid cell of 
+ *  radius, and the values in between are interpolated and projected onto x/y. 
+ *  This is switched on by the optional Green's function parameter 
+ *  'profile_tolerance' (relative error, 0: off).
+ *
+ *  With the optional Green's function parameter 'green_cache' set to 'on', the 
+ *  values of a plug-in that declares a symmetry are kept in a table on disk, 
+ *  $CRUSDE_HOME/cache/green/<key>.bin. The key is a hash of the plug-in's name 
+ *  and version, the Green's function parameters, the grid size and the model 
+ *  step. Later runs with the same key map the table and call the plug-in only 
+ *  for points it does not hold yet. The table holds the first quadrant, the 
+ *  other quadrants follow from the sign rules of RADIAL_SYMMETRY.
+ *
+ *  A job may consist of several plug-ins with weights (see 
+ *  InputHandler::getGreenJobMap()), its Green's function is the weighted sum. 
+ *  Each plug-in is loaded once, however many jobs use it. Operators can 
+ *  select a single component of the current job (selectComponent()), e.g. to 
+ *  transform each plug-in once and add the spectra of a job with the weights.
+ *
+ *  Plug-ins that export get_value_at_r() can be evaluated by several threads 
+ *  at once: each thread gets a workspace (newWorkspace()) and passes the 
+ *  quadrant explicitly instead of setting it in the core. Neither the radial 
+ *  profile nor the disk cache are used on this path, see isReentrant(). 
+ *  getRowAt() evaluates a whole row at once, with the plug-in's get_row_at() 
+ *  if it has one, point by point otherwise.
  */
+
+/** one term of a job: a Green's function plug-in and its weight */
+struct GreenComponent
+{
+	GreenPlugin *plugin;
+	double       weight;
+};
+
+/** scratch of one thread for the reentrant path, see GreensFunction::newWorkspace() */
+struct GreenWorkspace
+{
+	map<GreenPlugin*, void*> plugin;	/* workspaces of the plug-ins, NULL if a plug-in needs none */
+	vector<double>           value;		/* buffer for the values of single components */
+	vector<double>           row;		/* buffer for the rows of single components ... */
+	vector<double*>          row_pointer;	/* ... one per displacement dimension */
+};
+
 class GreensFunction : public Plugin
 {
 
 	private:
-		map<string, GreenPlugin*>::iterator  map_iter;
-		map<string, GreenPlugin*>            pl_green_map;
+		map<string, vector<GreenComponent> >::iterator  map_iter;
+		map<string, vector<GreenComponent> >            pl_green_map;	/* job name -> components */
+		map<string, GreenPlugin*>                       pl_plugin_map;	/* file name -> plug-in */
+		int            component;		/* component of the current job that is evaluated, -1: all */
+		vector<double> component_value;		/* buffers for the values of single components */
+		vector<double> component_imag;
+
+		double        *p_profile_tolerance;	/* relative error allowed for interpolated values, 0: no profile */
+		string         profile_function;		/* Green's function (pluginName()) and model step the profile was sampled for */
+		int            profile_step;
+		int            profile_direct;		/* radius (grid cells) below which the plug-in is called directly */
+		int            profile_checked;		/* diagonal points (k,k) compared to the plug-in so far */
+		vector<double> profile_z;		/* vertical and radial displacement at k grid cells from the load */
+		vector<double> profile_r;
+		double        *profile_value;		/* buffer for plug-in values */
+
+		char         **p_cache;			/* 'on': keep plug-in values in the disk cache, 'off': don't */
+		string         cache_key;		/* description of the plug-in and parameters the table belongs to */
+		string         cache_file;		/* file of the table, empty: not stored */
+		string         cache_function;		/* Green's function (pluginName()) and model step the table was opened for */
+		int            cache_step;
+		int            cache_nx;		/* table holds the points 0 <= x <= cache_nx, 0 <= y <= cache_ny */
+		int            cache_ny;
+		int            cache_dims;		/* values per point */
+		double        *cache_values;		/* values at (x,y) start at (x+(cache_nx+1)*y)*cache_dims, NaN: not sampled */
+		void          *cache_map;		/* mapped file holding cache_values, NULL: allocated */
+		size_t         cache_map_size;
+		bool           cache_dirty;		/* table has values the file does not have */
+
+		void resetProfile();
+		int  extendProfile(int);
+		void interpolateProfile(double*, double, int, int);
+
+		int  jobValueAt(double**, int, int);
+		int  pluginValueAt(double**, int, int);
+		int  pluginRowAt(GreenWorkspace*, GreenPlugin*, double**, int, int, int, int);
+		bool isComposite();
+		void openCache();
+		void growCache(int, int);
+		void flushCache();
 
 		/**hidden copy constructor - we do not want to accidentially copy objects*/
 		GreensFunction(const GreensFunction& x); 
@@ -66,13 +150,25 @@ class GreensFunction : public Plugin
 		bool nextJob();
 		bool isLastJob();
 		string job();
+		string pluginName();
+		string pluginVersion();
+		int    components();
+		double selectComponent(int);
 
 //		virtual void selftest();
 		
 		/*plug - in interface*/
 		int getValueArrayAt(double**, int, int);
+		bool isReentrant();
+		GreenWorkspace* newWorkspace();
+		void freeWorkspace(GreenWorkspace*);
+		int getValueArrayAt(GreenWorkspace*, double**, int, int, int);
+		int getRowAt(GreenWorkspace*, double**, int, int, int, int);
+		GreenSymmetry getSymmetry();
+		bool hasSpectrum();
+		int getSpectrumAt(double**, double**, double, double, double);
 
-        void load(map<string, string>);
+        void load(map<string, vector< pair<string, double> > >);
 		void unload() throw (LibHandleError);
 		void registerParameter();
 		void registerOutputFields();
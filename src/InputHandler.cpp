@@ -32,10 +32,10 @@
 #include "SimulationCore.h"
 #include "InputHandler.h"
 
-#include <stdlib.h>	/*atof*/
+#include <stdlib.h>	/*atof, strtod*/
 #include <unistd.h>	/*getopt*/
 #include <string.h>	/*strtok*/
-#include <ctype.h>	/*isprint*/
+#include <ctype.h>	/*isprint, isspace*/
 
 #include <string>	
 #include <map>
@@ -835,10 +835,20 @@ list<LoadFunctionElement*> InputHandler::getLoadFunctionList()
      return load_function;
 }
 
-map<string, string> InputHandler::getGreenJobMap()
+/**
+ * returns a map from job names to the Green's function plug-ins of the job. A job may list several 
+ * plug-ins, each with an optional attribute 'weight' (default 1); the job's Green's function is then 
+ * the weighted sum of them, e.g.
+ *
+ *   <job name="final relaxed">
+ *     <plugin name="elastic halfspace (pinel)" />
+ *     <plugin name="thick plate (pinel)" weight="1" />
+ *   </job>
+ */
+map<string, vector< pair<string, double> > > InputHandler::getGreenJobMap()
 {
 
-     map<string, string> green_job_map;
+     map<string, vector< pair<string, double> > > green_job_map;
 	
      //get the list of jobs that are described within the greens function definition.
      DOMElement  *green_elem = dynamic_cast<DOMElement*>( getElementByTagName(TAG_green.xmlStr()) );
@@ -852,7 +862,7 @@ map<string, string> InputHandler::getGreenJobMap()
           string name( getAttributeValue(TAG_green.xmlStr(), TAG_plugin.xmlStr(), ATTR_name.xmlStr()) );
           string path( (SimulationCore::instance()->pluginManager())->getFilename(string("green"), name) );
 
-          green_job_map.insert(pair<string, string > (string(), path) );
+          green_job_map[string()].push_back( pair<string, double>(path, 1.0) );
 
           return green_job_map;
      }
@@ -873,35 +883,54 @@ map<string, string> InputHandler::getGreenJobMap()
                //get job name
                StrXML job_name(job_elem->getAttribute(ATTR_name.xmlStr()));
 
-               map< string, string>::iterator iter = green_job_map.begin();
-               //walk through the input list, this way warnings are triggered if something is not registered
-               while(iter != green_job_map.end() )
+               if( green_job_map.find(job_name.cppStr()) != green_job_map.end() )
                {
-                    if((iter->first).compare(job_name.cppStr()) == 0)
-                    {
-                         crusde_error("Job %s defined twice! First time with Plug-in: %s", job_name.cStr(), iter->second.c_str()); 
-                    }
-                    ++iter;
+                    crusde_error("Job %s defined twice!", job_name.cStr()); 
                }
 
-               //get the plug-in node
-               //-------------------
-               //get the green-plugin
-               DOMElement *green_plugin_elem = dynamic_cast<DOMElement*>( job_elem->getElementsByTagName(TAG_plugin.xmlStr())->item(0) );
+               //get the plug-in nodes
+               //---------------------
+               DOMNodeList *plugin_list = job_elem->getElementsByTagName(TAG_plugin.xmlStr());
 
-               //we need a load plugin
-               if(!green_plugin_elem)
+               //we need a green plugin
+               if(plugin_list == NULL || plugin_list->getLength() == 0)
                {
                     crusde_error("No green plugin in job definition #%d found.", i);
                }
-               //get plug-in name and plug-in path
-               StrXML green_name(green_plugin_elem->getAttribute(ATTR_name.xmlStr()));
-               string path( (SimulationCore::instance()->pluginManager())->getFilename(string("green"), green_name.cppStr()) );
 
-               //add to map which will be returned
-               //---------------------------------
-               green_job_map.insert(pair<string,string>( job_name.cppStr(), path ) );
-               crusde_debug("%s, line: %d, Found Job: '%s' with plug-in '%s' (%s)", __FILE__, __LINE__, job_name.cStr(), green_name.cStr(), path.c_str());
+               unsigned int j(0);
+
+               while(j < plugin_list->getLength() )
+               {
+                    DOMElement *green_plugin_elem = dynamic_cast<DOMElement*>( plugin_list->item(j) );
+
+                    //get plug-in name, plug-in path and weight
+                    StrXML green_name(green_plugin_elem->getAttribute(ATTR_name.xmlStr()));
+                    StrXML weight(green_plugin_elem->getAttribute(ATTR_weight.xmlStr()));
+                    string path( (SimulationCore::instance()->pluginManager())->getFilename(string("green"), green_name.cppStr()) );
+                    double w(1.0);
+
+                    if( !weight.cppStr().empty() )
+                    {
+                         char *end(NULL);
+                         w = strtod(weight.cStr(), &end);
+
+                         while( end != weight.cStr() && isspace(*end) ) ++end;
+
+                         if( end == weight.cStr() || *end != '\0' )
+                         {
+                              crusde_error("Weight '%s' of plug-in '%s' in job '%s' is not a number.", 
+                                           weight.cStr(), green_name.cStr(), job_name.cStr());
+                         }
+                    }
+
+                    //add to map which will be returned
+                    //---------------------------------
+                    green_job_map[job_name.cppStr()].push_back( pair<string, double>(path, w) );
+                    crusde_debug("%s, line: %d, Found Job: '%s' with plug-in '%s' (%s), weight %g", __FILE__, __LINE__, job_name.cStr(), green_name.cStr(), path.c_str(), w);
+
+                    ++j;
+               }
           }
           ++i;
      }
@@ -36,6 +36,7 @@
 #include <string>
 #include <stdexcept>
 #include <map>
+#include <vector>
 
 class ParamWrapper;
 class LoadFunctionElement;
@@ -75,7 +76,7 @@ class InputHandler : public XMLHandler
 		/*GETTERS*/
 		/*********/
 //		string getGreenPlugin();
-		map<string, string> getGreenJobMap();
+		map<string, vector< pair<string, double> > > getGreenJobMap();
 		string getGreenPlugin(string);
 		string getLoadPlugin();
 		string getLoadPlugin(string);
@@ -53,6 +53,8 @@ char** ParamWrapper::newString(char* val)
 	{
 		string_param = new string();
 		cStr  = (char*) malloc(sizeof(char*));
+		//optional parameters keep their default value unless the input sets them
+		setValue( string(val == NULL ? "" : val) );
 	}
 	else
 	{
@@ -397,6 +397,18 @@ run_function Plugin::getRunFunction()
   return func_run; 
 }
 
+/**address of a function the plugin may export besides its interface, NULL if it does not*/
+void* Plugin::getFunction(string func_name)
+{
+  if(!is_loaded)
+  	return NULL;
+
+  /* clear error flag */
+  dlerror();
+
+  return dlsym( LibHandle, func_name.c_str() );
+}
+
 /**tells whether Plugin::load() was called and succeeded*/
 bool Plugin::isLoaded()
 {
@@ -114,6 +114,7 @@ class Plugin
 		void setCategory(string new_type);
 		
 		run_function getRunFunction();
+		void* getFunction(string func_name);	/*address of an optional function, NULL if the plugin does not export it*/
 };
 
 #endif // _plugin_h
@@ -618,6 +618,27 @@ run_function SimulationCore::addPostprocessorPlugin(string plugin) throw (FileNo
 	}
 }
 
+/**
+ * looks up an optional function of a kernel plugin that was requested with addKernelPlugin(), 
+ * e.g. an entry point besides run() that lets a plugin reuse parts of another one.
+ * returns NULL if the plugin was not requested or does not export the function.
+ */
+void* SimulationCore::getKernelFunction(string plugin, string function)
+{
+	list<Plugin*>::iterator iter = requested_plugin_list.begin();
+
+	while(iter != requested_plugin_list.end())
+	{
+		if( (*iter)->getCategoryID() == KERNEL_PLUGIN && (*iter)->getName() == plugin )
+		{
+			return (*iter)->getFunction(function);
+		}
+		++iter;
+	}
+
+	return NULL;
+}
+
 loadhistory_exec_function SimulationCore::addLoadHistoryPlugin(string plugin) throw (FileNotFound, runtime_error)
 {
 	try{
@@ -751,6 +772,18 @@ string SimulationCore::currentJob()
 {
 	return greens_function->job();
 }
+
+const char* SimulationCore::currentJobName()
+{
+	current_job = greens_function->job();
+	return current_job.c_str();
+}
+
+const char* SimulationCore::currentGreenPlugin()
+{
+	current_green_plugin = greens_function->pluginName();
+	return current_green_plugin.c_str();
+}
 void SimulationCore::setModelData(double **result)
 { 
 	model_data = result;
@@ -813,7 +846,7 @@ int SimulationCore::displacementDimensions(){
 
 void SimulationCore::setOperatorSpace(int nx, int ny)
 {
-	operator_space_x = ny;
+	operator_space_x = nx;
 	operator_space_y = ny;
 
 	operator_space_set = true;
@@ -139,6 +139,8 @@ class SimulationCore /*: 	public PluginAPI,
 
 	string	root_dir;
 	string	out_file;
+	string	current_job;
+	string	current_green_plugin;
 
 	int operator_space_x;
 	int operator_space_y;
@@ -263,6 +265,8 @@ class SimulationCore /*: 	public PluginAPI,
 	void registerOutputField(int *output_index, FieldName field);
 
 	string currentJob();
+	const char* currentJobName();
+	const char* currentGreenPlugin();
 
 	void setQuiet(bool);
 	bool isQuiet();
@@ -274,6 +278,7 @@ class SimulationCore /*: 	public PluginAPI,
 	run_function                 addPostprocessorPlugin(string plugin) throw (FileNotFound, runtime_error);
 	loadhistory_exec_function    addLoadHistoryPlugin(string plugin) throw (FileNotFound, runtime_error);
 	crustaldecay_exec_function   addCrustalDecayPlugin(string plugin) throw (FileNotFound, runtime_error);
+	void*                        getKernelFunction(string plugin, string function);
 
 };
 
@@ -153,7 +153,8 @@ XMLHandler::XMLHandler(const char *filename):
 	ATTR_localtime("localtime"),
 	ATTR_name("name"),
 	ATTR_user("user"),
-	ATTR_value("value")
+	ATTR_value("value"),
+	ATTR_weight("weight")
 {
  
 	// Configure DOM parser.
@@ -164,6 +164,7 @@ class XMLHandler : private XMLCore
 		const StrXML ATTR_name;
 		const StrXML ATTR_user;
 		const StrXML ATTR_value;
+		const StrXML ATTR_weight;
 						
 		list<string> getNodesChildDataList(XMLCh *parent, XMLCh *child);
 		string   getChildData(DOMNode *parent, const XMLCh* childname);
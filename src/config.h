@@ -29,6 +29,11 @@
 #define _config_h
 
 typedef int (*green_exec_function)(double**, int, int);		//!< function pointer to exec function of green's function plug-in
+typedef int (*green_exec_r_function)(void*, double**, int, int, int);	//!< function pointer to the optional reentrant exec function of green's function plug-in
+typedef int (*green_row_function)(void*, double**, int, int, int, int);	//!< function pointer to the optional row evaluator of green's function plug-in
+typedef void* (*green_workspace_function)();				//!< function pointer to the optional workspace constructor of green's function plug-in
+typedef void (*green_workspace_free_function)(void*);			//!< function pointer to the optional workspace destructor of green's function plug-in
+typedef int (*green_spectrum_function)(double**, double**, double, double, double);	//!< function pointer to the optional spectrum of a green's function plug-in
 typedef double (*load_exec_function)(int, int);				//!< function pointer to exec function of load function plug-in
 typedef double (*loadhistory_exec_function)(unsigned int);	//!< function pointer to exec function of load history plug-in
 typedef double (*crustaldecay_exec_function)(unsigned int);	//!< function pointer to exec function of load history plug-in
@@ -353,6 +353,165 @@ extern "C" int crusde_get_green_at(double **result, int x, int y)
     return SimulationCore::instance()->greensFunction()->getValueArrayAt(result,x,y);
 }
 
+//! Tells whether the Green's function of the current job can be evaluated by several threads at once
+/*!
+	A Green's function plug-in may export 
+	<tt>int get_value_at_r(void* workspace, double** result, int x, int y, int quadrant)</tt>, 
+	which keeps its scratch data in the workspace and takes the quadrant as an argument instead 
+	of crusde_get_quadrant(). If the plug-in needs a workspace, it also exports 
+	<tt>void* new_workspace()</tt> and <tt>void free_workspace(void*)</tt>. The core's radial 
+	profile and disk cache (Green's function parameters 'profile_tolerance', 'green_cache') are 
+	not reentrant, with either of them in use this returns false.
+
+	\return true if all Green's functions of the current job (or the selected component) 
+	        export <tt>get_value_at_r()</tt>
+	\sa crusde_get_green_at_r(), crusde_new_green_workspace()
+*/
+extern "C" boolean crusde_green_is_reentrant()
+{
+    return SimulationCore::instance()->greensFunction()->isReentrant() ? true : false;
+}
+
+//! Get a workspace for crusde_get_green_at_r()
+/*!
+	Each thread that evaluates the Green's function needs a workspace of its own. A workspace 
+	serves all jobs. This function is not reentrant, create the workspaces before starting 
+	the threads and free them with crusde_free_green_workspace().
+
+	\return workspace
+	\sa crusde_get_green_at_r()
+*/
+extern "C" void* crusde_new_green_workspace()
+{
+    return SimulationCore::instance()->greensFunction()->newWorkspace();
+}
+
+//! Free a workspace of crusde_new_green_workspace()
+/*! \sa crusde_new_green_workspace()*/
+extern "C" void crusde_free_green_workspace(void *workspace)
+{
+    SimulationCore::instance()->greensFunction()->freeWorkspace( (GreenWorkspace*) workspace );
+}
+
+//! Get value of Green's function at a specific coordinate, reentrant
+/*!
+	Same as crusde_get_green_at() with crusde_set_quadrant(quadrant) before, but threads with 
+	different workspaces may call it at the same time. Only valid while 
+	crusde_green_is_reentrant() is true; the job and the selected component must not change 
+	meanwhile.
+
+    \param workspace	workspace of the calling thread, see crusde_new_green_workspace()
+    \param result 	pointer to array to which the Green's function (possibly for 3 spatial dimensions) is written
+    \param x,y		spatial coordinates for which the Green's function is requested
+    \param quadrant	quadrant (1-4) the point lies in, gives the direction of the horizontal components
+    \return Error code	
+	\sa crusde_green_is_reentrant()
+*/
+extern "C" int crusde_get_green_at_r(void *workspace, double **result, int x, int y, int quadrant)
+{
+    return SimulationCore::instance()->greensFunction()->getValueArrayAt( (GreenWorkspace*) workspace, result, x, y, quadrant );
+}
+
+//! Get the values of Green's function along a row, reentrant
+/*!
+	Evaluates the points (x+i, y), 0 <= i < n, of a quadrant at once. A Green's function plug-in 
+	may export <tt>int get_row_at(void* workspace, double** row, int x, int y, int n, int quadrant)</tt> 
+	with a loop over the row that the compiler can vectorise; plug-ins without it are evaluated 
+	point by point with <tt>get_value_at_r()</tt>. Conditions as for crusde_get_green_at_r().
+
+    \param workspace	workspace of the calling thread, see crusde_new_green_workspace()
+    \param row 		row[d] is the array of n values of displacement dimension d, 
+			see crusde_get_x_index() etc.
+    \param x,y		spatial coordinates of the first point, x, y >= 0
+    \param n		number of points
+    \param quadrant	quadrant (1-4) the points lie in, gives the direction of the horizontal components
+    \return Error code	
+	\sa crusde_get_green_at_r(), crusde_green_is_reentrant()
+*/
+extern "C" int crusde_get_green_row_at(void *workspace, double **row, int x, int y, int n, int quadrant)
+{
+    return SimulationCore::instance()->greensFunction()->getRowAt( (GreenWorkspace*) workspace, row, x, y, n, quadrant );
+}
+
+//! Get the symmetry the Green's function of the current job declares
+/*!
+	A Green's function plug-in may export <tt>GreenSymmetry get_symmetry()</tt>. If it returns 
+	RADIAL_SYMMETRY, the values in quadrants 2-4 equal those of quadrant 1 at (|x|,|y|) with the 
+	x-component negated for x < 0 (quadrants 3, 4) and the y-component negated for y < 0 
+	(quadrants 2, 3); the z-component is even. Operators can then evaluate the first quadrant 
+	only and fill the others by reflection. AXIAL_SYMMETRY implies these rules and further says 
+	the Green's function depends on the distance r only, with a radial horizontal displacement; 
+	the core can then interpolate it from a radial profile (see GreensFunction). Plug-ins without 
+	get_symmetry() yield NO_SYMMETRY.
+
+	\sa crusde_get_green_at(), crusde_set_quadrant()
+*/
+extern "C" GreenSymmetry crusde_get_green_symmetry()
+{
+    return SimulationCore::instance()->greensFunction()->getSymmetry();
+}
+
+//! Tells whether the Green's functions of all jobs provide a spectrum
+/*!
+	\return true if every Green's function plug-in exports <tt>get_spectrum_at()</tt>
+	\sa crusde_get_green_spectrum_at()
+*/
+extern "C" boolean crusde_green_has_spectrum()
+{
+    return SimulationCore::instance()->greensFunction()->hasSpectrum() ? true : false;
+}
+
+//! Get the spectrum of the Green's function of the current job
+/*!
+	A Green's function plug-in may export 
+	<tt>int get_spectrum_at(double** re, double** im, double kx, double ky, double radius)</tt>. 
+	It gives the 2D discrete Fourier transform of the Green's function on the model grid, 
+	i.e. the sum of G(p) exp(-i k.p) over all grid points p with |p| <= radius, where G(p) is the 
+	Green's function averaged over the grid cell around p. This is what a convolution operator 
+	gets from transforming the sampled Green's function, without the sampling error at r = 0. 
+	Operators can multiply it with the load spectrum directly.
+
+    \param re, im	pointers to arrays to which the real and imaginary parts of the spectrum 
+			(possibly for 3 spatial dimensions) are written
+    \param kx, ky	wavenumber [rad/m], at most pi/gridsize in magnitude
+    \param radius	radius of the disk the Green's function is truncated to [m]
+    \return Error code	
+	\sa crusde_green_has_spectrum(), crusde_get_green_at()
+*/
+extern "C" int crusde_get_green_spectrum_at(double **re, double **im, double kx, double ky, double radius)
+{
+    return SimulationCore::instance()->greensFunction()->getSpectrumAt(re, im, kx, ky, radius);
+}
+
+//! Get the number of Green's functions the current job is the weighted sum of
+/*!
+	A job of the experiment definition may list several Green's function plug-ins, each with 
+	an attribute 'weight' (default 1). crusde_get_green_at() and crusde_get_green_spectrum_at() 
+	then return the weighted sum. A job with a single plug-in has one component.
+
+	\sa crusde_select_green_component()
+*/
+extern "C" int crusde_get_green_components()
+{
+    return SimulationCore::instance()->greensFunction()->components();
+}
+
+//! Restrict the current job to one of its Green's functions
+/*!
+	Until the job changes or -1 is selected, crusde_get_green_at(), crusde_get_green_spectrum_at(), 
+	crusde_get_green_symmetry() and crusde_get_current_green_plugin() refer to the component i 
+	alone, without its weight. Operators can thus transform each plug-in once, however many jobs 
+	use it, and add up the spectra of a job with the weights.
+
+    \param i		component, 0 <= i < crusde_get_green_components(), or -1 for the whole job
+    \return the weight of component i, 1 for -1
+	\sa crusde_get_green_components()
+*/
+extern "C" double crusde_select_green_component(int i)
+{
+    return SimulationCore::instance()->greensFunction()->selectComponent(i);
+}
+
 //! Get value of Load function at Point p(x,y).
 /*!
 	\param x,y 		X,Y coordinates of grid point at which the load value is sought.
@@ -487,6 +646,26 @@ extern "C" const char* crusde_get_out_file()
     return SimulationCore::instance()->outFile();
 }
 
+//! Returns the name of the Green's function job that is currently worked on
+/*! 
+	Jobs are defined in the 'greens_function' section of the XML model file. If no job name was
+	defined, a name is derived from the Green's function plugin. Operators can use this string
+	to identify results that stay valid as long as the same job is processed.
+
+	\sa crusde_get_current_green_plugin()
+*/
+extern "C" const char* crusde_get_current_job()
+{
+    return SimulationCore::instance()->currentJobName();
+}
+
+//! Returns the name of the Green's function plugin that is used by the current job
+/*! \sa crusde_get_current_job()*/
+extern "C" const char* crusde_get_current_green_plugin()
+{
+    return SimulationCore::instance()->currentGreenPlugin();
+}
+
 
 //! Gracefully terminates CrusDe, i.e. shuts down the whole system before exiting with ExitCode 'code'
 /*! \sa ExitCode */
@@ -631,6 +810,24 @@ extern "C" load_exec_function crusde_request_load_plugin(char* plugin)
 
 }
 
+//! An Operator/Kernel plugin can request a function another operator/kernel plug-in exports besides its interface
+/*!
+	The plug-in must have been requested with crusde_request_kernel_plugin() before. This lets an operator
+	use more of another one than its run() function, e.g. 'fast 3d convolution' convolves all loads at once 
+	with <tt>boolean convolve_loads(int loads, double*** out)</tt> of 'fast 2d convolution'. That function
+	returns false if it did not convolve the loads, which it does not in single precision; the caller
+	must check this and convolve load by load with run() then.
+
+	\param 	plugin					Name of the operator as defined in Plugin Manager, e.g. "fast 2d convolution"
+	\param 	function				Name of the exported function
+	\return 						Address of the function, NULL if the operator was not requested or does not export it.
+	\sa crusde_request_kernel_plugin()
+ */
+extern "C" void* crusde_request_kernel_function(char* plugin, char* function)
+{
+	return SimulationCore::instance()->getKernelFunction( string(plugin), string(function) );
+}
+
 //! An Operator/Kernel plugin can request the run time function of another operator/kernel plug-in to reuse its functionality
 /*!
 	\param 	plugin					Name of the operator to be re-used as defined in Plugin Manager, e.g. "fast 2d convolution"
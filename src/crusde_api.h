@@ -67,6 +67,12 @@ typedef enum{
 	ADD_FIELD = 3
 }FieldName;
 
+typedef enum{
+	NO_SYMMETRY = 0,		//!< nothing known, the Green's function is evaluated in every quadrant
+	RADIAL_SYMMETRY = 1,		//!< z even in x and y, x odd in x and even in y, y even in x and odd in y
+	AXIAL_SYMMETRY = 2		//!< as RADIAL_SYMMETRY, and a function of r only: z = G_z(r), (x,y) = u_r(r)*(cos, sin)
+}GreenSymmetry;
+
 typedef enum{
 	ERROR_MSG = 1,			//!< error message printed, aborting program
 	NOERROR	= 0				//!< no error occured
@@ -107,9 +113,24 @@ int 		crusde_get_z_index();                       /*index of z-displacement valu
 
 const char* 	crusde_get_observation_file();	        /*filename of points to be observed (unused)*/
 const char* 	crusde_get_out_file();		            /*filename for result output*/
+const char* 	crusde_get_current_job();	            /*name of the Green's function job currently worked on*/
+const char* 	crusde_get_current_green_plugin();	    /*name of the Green's function plugin of the current job*/
 
 int 		crusde_get_green_at(double** res, int x, int y);
 												/*green's function coefficients at x,y*/
+boolean		crusde_green_is_reentrant();		/*tells whether crusde_get_green_at_r() may be called by several threads*/
+void*		crusde_new_green_workspace();		/*workspace of one thread for crusde_get_green_at_r()*/
+void		crusde_free_green_workspace(void* ws);
+int		crusde_get_green_at_r(void* ws, double** res, int x, int y, int quadrant);
+							/*green's function coefficients at x,y in quadrant, reentrant*/
+int		crusde_get_green_row_at(void* ws, double** row, int x, int y, int n, int quadrant);
+							/*green's function coefficients at x ... x+n-1, y in quadrant, reentrant*/
+GreenSymmetry	crusde_get_green_symmetry();		/*symmetry declared by the green's function of the current job*/
+boolean		crusde_green_has_spectrum();		/*tells whether the green's functions of all jobs provide a spectrum*/
+int		crusde_get_green_spectrum_at(double** re, double** im, double kx, double ky, double radius);
+							/*spectrum of the green's function at wavenumber kx,ky*/
+int		crusde_get_green_components();		/*number of green's functions the current job is the weighted sum of*/
+double		crusde_select_green_component(int i);	/*restrict the current job to its i-th green's function, -1: all*/
 double 		crusde_get_load_at(int x, int y);	/*load at x,y,t*/
 double 		crusde_get_load_history_at(int t);  /*load history at t*/
 double 		crusde_get_crustal_decay_at(int t); /*crustal decay at t*/
@@ -139,6 +160,7 @@ run_function                crusde_request_kernel_plugin(char* plugin);
 run_function                crusde_request_postprocessor_plugin(char* plugin);
 loadhistory_exec_function   crusde_request_loadhistory_plugin(char* plugin);
 crustaldecay_exec_function  crusde_request_crustaldecay_plugin(char* plugin);
+void*                       crusde_request_kernel_function(char* plugin, char* function);	/*optional function of a requested kernel plugin, NULL if absent*/
 
 	
 /*void	crusde_print_green_params();
@@ -58,6 +58,8 @@ load_history=(
 operator=(
     operator/fast_conv
     operator/fast_conv_time_space
+    operator/fast_conv_tiled
+    operator/hankel_conv
 )
 
 postprocessors=(
@@ -23,6 +23,14 @@
  * The 'file' parameter must point to an ALMA3 rheological model file
  * (absolute path, or path relative to $ALMA).
  *
+ * The Love number tables are cached in $CRUSDE_HOME/cache/alma/<key>.bin, where
+ * key is a hash of the generated config (without the temp file paths) and the
+ * contents of the model file. A cache hit is memory-mapped and ALMA3 is not called
+ * at all. On a miss, alma.exe is started in the background during init() and only
+ * waited for when the first Green's function value is requested, so it runs while
+ * the remaining plugins initialise. Remove the cache directory after updating
+ * ALMA3 itself.
+ *
  * get_value_at() implements the Farrell (1972) loading Green's function
  * using a Legendre polynomial series truncated at deg_max.
  * NOTE: for accurate near-field results with small loads (radius r), deg_max
@@ -34,9 +42,18 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdint.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
 #include "crusde_api.h"
 
+extern char **environ;
+
 /* --- registered parameter pointers --- */
 double *p_deg_min;
 double *p_deg_max;
@@ -55,12 +72,45 @@ float **love_number_h;
 float **love_number_k;
 float **love_number_l;
 
+/* storage behind the love_number_* rows: either a mapped cache file or love_data */
+float  *love_data     = NULL;
+void   *love_map      = NULL;
+size_t  love_map_size = 0;
+
+int    love_times, love_degrees;
+pid_t  alma_pid = 0;            /* running alma.exe, 0 if none */
+
+char config_file[512], log_file[512];
+char h_file[512], l_file[512], k_file[512];
+char cache_file[1024];          /* empty if there is no $CRUSDE_HOME */
+
+/* Love numbers of the tabulated time step, indexed by degree 0..deg_max and zero for
+ * degrees not in deg_min:deg_step:deg_max */
+double *coef_h = NULL;
+double *coef_l = NULL;
+
+/* Legendre sums over angular distance theta = i*table_step of the time step table_time */
+double *table_z = NULL;         /* sum h_n P_n(cos theta)          */
+double *table_l = NULL;         /* sum l_n dP_n(cos theta)/dtheta  */
+double  table_step;
+int     table_time  = -1;
+int     table_size  = 0;        /* number of computed entries */
+int     table_alloc = 0;
+
+/*! header of a cache file, followed by the h, l and k tables, each [times][degrees] */
+typedef struct {
+    char magic[8];              /* "CRALMA01" */
+    int  times;
+    int  degrees;
+} AlmaCacheHeader;
+
 void read_alma_output(const char *file, float **love_array, int times, int degrees);
 
 extern const char* get_name()     { return "alma"; }
 extern const char* get_version()  { return "0.2"; }
 extern const char* get_authors()  { return "ronni grapenthin"; }
 extern PluginCategory get_category() { return GREEN_PLUGIN; }
+extern GreenSymmetry get_symmetry()  { return AXIAL_SYMMETRY; }
 extern const char* get_description() {
     return "Interface to ALMA3 (Melini et al. 2022) for computing viscoelastic "
            "Love numbers. Set $ALMA to the directory containing alma.exe. "
@@ -96,92 +146,212 @@ extern void register_output_fields()
 
 extern void request_plugins() {}
 
-extern void init()
+/*! writes the ALMA3 config to buf, returns the number of characters written */
+static int alma_config(char *buf, size_t size, const char *model_file, const char *log,
+                       const char *h, const char *l, const char *k)
 {
-    const char *alma_dir = getenv("ALMA");
-    if (alma_dir == NULL) {
-        crusde_error("Error: Environment variable ALMA is not defined!\n"
-                     "Set it to the directory that contains alma.exe.\n");
+    return snprintf(buf, size,
+        "%d           ! number of significant digits\n"
+        "%d           ! order of Gaver sequence\n"
+        "Loading      ! LN type\n"
+        "%d           ! minimum degree\n"
+        "%d           ! maximum degree\n"
+        "%d           ! degree step\n"
+        "lin          ! time scale (linear)\n"
+        "%d           ! number of time subdivisions\n"
+        "%d %d        ! time range (kyrs)\n"
+        "step         ! load time history\n"
+        "1.0          ! ramp length (unused for step)\n"
+        "%d           ! number of layers\n"
+        "%s\n"
+        "%s\n"
+        "Real         ! Real LNs\n"
+        "ln_vs_n      ! output format: LNs vs harmonic degree\n"
+        "%s\n"
+        "%s\n"
+        "%s\n",
+        (int)*p_sd, (int)*p_ng, (int)*p_deg_min, (int)*p_deg_max, (int)*p_deg_step,
+        (int)*p_p, (int)*p_time_min, (int)*p_time_max, (int)*p_nla,
+        model_file, log, h, l, k);
+}
+
+/* FNV-1a */
+static uint64_t hash_bytes(uint64_t hash, const unsigned char *data, size_t n)
+{
+    size_t i = 0;
+    while (i < n) {
+        hash ^= data[i++];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/*! hashes the generated config (without temp file paths) and the model file contents */
+static uint64_t cache_key(const char *model_file)
+{
+    char config[4096];
+    int length = alma_config(config, sizeof(config), model_file, "", "", "", "");
+    uint64_t hash = hash_bytes(14695981039346656037ULL, (const unsigned char*)config, length);
+
+    FILE *fi = fopen(model_file, "rb");
+    if (fi == NULL) {
+        crusde_error("Could not read ALMA3 model file: %s", model_file);
         crusde_exit(-1);
     }
 
-    int times   = (int)(*p_p) + 1;
-    int degrees = (int)ceil((*p_deg_max - *p_deg_min + 1.0) / *p_deg_step);
-    pid_t pid   = getpid();
+    unsigned char block[4096];
+    size_t n;
+    while ((n = fread(block, 1, sizeof(block), fi)) > 0) {
+        hash = hash_bytes(hash, block, n);
+    }
+    fclose(fi);
+
+    return hash;
+}
+
+/*! points the love_number_* rows into base, which holds h, l and k one after another */
+static void set_rows(float *base)
+{
+    love_number_h = (float**) malloc(sizeof(float*) * love_times);
+    love_number_k = (float**) malloc(sizeof(float*) * love_times);
+    love_number_l = (float**) malloc(sizeof(float*) * love_times);
+    if (!love_number_h || !love_number_k || !love_number_l) { crusde_bad_alloc(); }
+
+    size_t table = (size_t)love_times * love_degrees;
+    int t = -1;
+    while (++t < love_times) {
+        love_number_h[t] = base + (size_t)t * love_degrees;
+        love_number_l[t] = base + table + (size_t)t * love_degrees;
+        love_number_k[t] = base + 2 * table + (size_t)t * love_degrees;
+    }
+}
+
+/*! maps cache_file, returns 0 if it does not exist or does not fit the current parameters */
+static int load_cache()
+{
+    if (cache_file[0] == '\0') return 0;
+
+    int fd = open(cache_file, O_RDONLY);
+    if (fd < 0) return 0;
+
+    size_t size = sizeof(AlmaCacheHeader) + 3 * sizeof(float) * (size_t)love_times * love_degrees;
+    struct stat info;
+    void *map = MAP_FAILED;
+
+    if (fstat(fd, &info) == 0 && (size_t)info.st_size == size) {
+        map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+
+    if (map == MAP_FAILED) return 0;
+
+    const AlmaCacheHeader *header = (const AlmaCacheHeader*) map;
+    if (memcmp(header->magic, "CRALMA01", 8) != 0 ||
+        header->times != love_times || header->degrees != love_degrees) {
+        crusde_warning("Ignoring invalid ALMA3 cache file <%s>", cache_file);
+        munmap(map, size);
+        return 0;
+    }
+
+    love_map      = map;
+    love_map_size = size;
+    set_rows((float*)((char*)map + sizeof(AlmaCacheHeader)));
+
+    crusde_info("Loaded ALMA3 Love numbers from cache <%s>", cache_file);
+    return 1;
+}
+
+/* The tables go to a temporary file first, which is then renamed. Concurrent runs thus 
+ * never read a partially written cache. */
+static void write_cache()
+{
+    if (cache_file[0] == '\0') return;
+
+    char temp[1100];
+    snprintf(temp, sizeof(temp), "%s.%d", cache_file, (int)getpid());
+
+    FILE *fo = fopen(temp, "wb");
+    if (fo == NULL) {
+        crusde_warning("Could not write ALMA3 cache file <%s>", temp);
+        return;
+    }
+
+    AlmaCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "CRALMA01", 8);
+    header.times   = love_times;
+    header.degrees = love_degrees;
+
+    size_t n = 3 * (size_t)love_times * love_degrees;
+    int written = fwrite(&header, sizeof(header), 1, fo) == 1 &&
+                  fwrite(love_data, sizeof(float), n, fo) == n;
+
+    if (fclose(fo) == 0 && written && rename(temp, cache_file) == 0) {
+        crusde_info("Stored ALMA3 Love numbers in cache <%s>", cache_file);
+    } else {
+        crusde_warning("Could not write ALMA3 cache file <%s>", cache_file);
+        remove(temp);
+    }
+}
+
+/*! writes the config file and starts alma.exe without waiting for it */
+static void start_alma(const char *alma_dir, const char *model_file)
+{
+    pid_t pid = getpid();
 
-    /* paths for temp files */
-    char config_file[512], log_file[512];
-    char h_file[512], l_file[512], k_file[512];
     sprintf(config_file, "/tmp/crusde_alma_%d.cfg", pid);
     sprintf(log_file,    "/tmp/crusde_alma_%d.log", pid);
     sprintf(h_file,      "/tmp/crusde_alma_h_%d.dat", pid);
     sprintf(l_file,      "/tmp/crusde_alma_l_%d.dat", pid);
     sprintf(k_file,      "/tmp/crusde_alma_k_%d.dat", pid);
 
-    /* resolve model file: use as-is if absolute, otherwise prepend $ALMA */
-    char model_file[512];
-    if ((*p_file)[0] == '/') {
-        strncpy(model_file, *p_file, sizeof(model_file) - 1);
-        model_file[sizeof(model_file) - 1] = '\0';
-    } else {
-        snprintf(model_file, sizeof(model_file), "%s/%s", alma_dir, *p_file);
-    }
+    char config[4096];
+    alma_config(config, sizeof(config), model_file, log_file, h_file, l_file, k_file);
 
-    /* write ALMA3 config file */
     FILE *cfg = fopen(config_file, "w");
     if (cfg == NULL) {
         crusde_error("Could not create ALMA3 config file: %s", config_file);
         crusde_exit(-1);
     }
-
-    fprintf(cfg, "%d           ! number of significant digits\n", (int)*p_sd);
-    fprintf(cfg, "%d           ! order of Gaver sequence\n",      (int)*p_ng);
-    fprintf(cfg, "Loading      ! LN type\n");
-    fprintf(cfg, "%d           ! minimum degree\n",  (int)*p_deg_min);
-    fprintf(cfg, "%d           ! maximum degree\n",  (int)*p_deg_max);
-    fprintf(cfg, "%d           ! degree step\n",     (int)*p_deg_step);
-    fprintf(cfg, "lin          ! time scale (linear)\n");
-    fprintf(cfg, "%d           ! number of time subdivisions\n", (int)*p_p);
-    fprintf(cfg, "%d %d        ! time range (kyrs)\n", (int)*p_time_min, (int)*p_time_max);
-    fprintf(cfg, "step         ! load time history\n");
-    fprintf(cfg, "1.0          ! ramp length (unused for step)\n");
-    fprintf(cfg, "%d           ! number of layers\n", (int)*p_nla);
-    fprintf(cfg, "%s\n",       model_file);
-    fprintf(cfg, "%s\n",       log_file);
-    fprintf(cfg, "Real         ! Real LNs\n");
-    fprintf(cfg, "ln_vs_n      ! output format: LNs vs harmonic degree\n");
-    fprintf(cfg, "%s\n", h_file);
-    fprintf(cfg, "%s\n", l_file);
-    fprintf(cfg, "%s\n", k_file);
+    fputs(config, cfg);
     fclose(cfg);
 
-    /* call ALMA3 */
-    char alma_call[1024];
-    snprintf(alma_call, sizeof(alma_call), "%s/alma.exe %s", alma_dir, config_file);
-    crusde_info("Calling ALMA3: %s", alma_call);
-    int ret = system(alma_call);
+    char alma_exe[512];
+    snprintf(alma_exe, sizeof(alma_exe), "%s/alma.exe", alma_dir);
+
+    char *argv[3];
+    argv[0] = alma_exe;
+    argv[1] = config_file;
+    argv[2] = NULL;
+
+    crusde_info("Calling ALMA3: %s %s", alma_exe, config_file);
+    int ret = posix_spawn(&alma_pid, alma_exe, NULL, NULL, argv, environ);
     if (ret != 0) {
-        crusde_error("ALMA3 returned non-zero exit code: %d", ret);
+        crusde_error("Could not start ALMA3 (%s): %s", alma_exe, strerror(ret));
         crusde_exit(-1);
     }
+}
 
-    /* allocate love number arrays: [time][degree] */
-    love_number_h = (float**) malloc(sizeof(float*) * times);
-    love_number_k = (float**) malloc(sizeof(float*) * times);
-    love_number_l = (float**) malloc(sizeof(float*) * times);
-    if (!love_number_h || !love_number_k || !love_number_l) { crusde_bad_alloc(); }
+/*! waits for alma.exe, reads its output and stores it in the cache */
+static void finish_alma()
+{
+    int status = 0;
+    pid_t ret;
+    while ((ret = waitpid(alma_pid, &status, 0)) < 0 && errno == EINTR);
+    alma_pid = 0;
 
-    int t = -1;
-    while (++t < times) {
-        love_number_h[t] = (float*) calloc(degrees, sizeof(float));
-        love_number_k[t] = (float*) calloc(degrees, sizeof(float));
-        love_number_l[t] = (float*) calloc(degrees, sizeof(float));
-        if (!love_number_h[t] || !love_number_k[t] || !love_number_l[t]) { crusde_bad_alloc(); }
+    if (ret < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        crusde_error("ALMA3 returned non-zero exit code: %d", WIFEXITED(status) ? WEXITSTATUS(status) : status);
+        crusde_exit(-1);
     }
 
-    read_alma_output(h_file, love_number_h, times, degrees);
-    read_alma_output(l_file, love_number_l, times, degrees);
-    read_alma_output(k_file, love_number_k, times, degrees);
+    love_data = (float*) calloc(3 * (size_t)love_times * love_degrees, sizeof(float));
+    if (!love_data) { crusde_bad_alloc(); }
+    set_rows(love_data);
+
+    read_alma_output(h_file, love_number_h, love_times, love_degrees);
+    read_alma_output(l_file, love_number_l, love_times, love_degrees);
+    read_alma_output(k_file, love_number_k, love_times, love_degrees);
 
     /* clean up temp files */
     remove(config_file);
@@ -189,24 +359,178 @@ extern void init()
     remove(h_file);
     remove(l_file);
     remove(k_file);
+
+    write_cache();
+}
+
+extern void init()
+{
+    const char *alma_dir = getenv("ALMA");
+    if (alma_dir == NULL) {
+        crusde_error("Error: Environment variable ALMA is not defined!\n"
+                     "Set it to the directory that contains alma.exe.\n");
+        crusde_exit(-1);
+    }
+
+    love_times   = (int)(*p_p) + 1;
+    love_degrees = (int)ceil((*p_deg_max - *p_deg_min + 1.0) / *p_deg_step);
+
+    /* resolve model file: use as-is if absolute, otherwise prepend $ALMA */
+    char model_file[512];
+    if ((*p_file)[0] == '/') {
+        strncpy(model_file, *p_file, sizeof(model_file) - 1);
+        model_file[sizeof(model_file) - 1] = '\0';
+    } else {
+        snprintf(model_file, sizeof(model_file), "%s/%s", alma_dir, *p_file);
+    }
+
+    /* cache file: $CRUSDE_HOME/cache/alma/<key>.bin */
+    cache_file[0] = '\0';
+    const char *home = getenv("CRUSDE_HOME");
+    if (home != NULL) {
+        char dir[1000];
+        snprintf(dir, sizeof(dir), "%s/cache", home);
+        if ((mkdir(dir, 0755) == 0 || errno == EEXIST) &&
+            (mkdir(strcat(dir, "/alma"), 0755) == 0 || errno == EEXIST)) {
+            snprintf(cache_file, sizeof(cache_file), "%s/%016llx.bin", dir,
+                     (unsigned long long) cache_key(model_file));
+        } else {
+            crusde_warning("Could not create ALMA3 cache directory <%s>", dir);
+        }
+    }
+
+    if (!load_cache()) {
+        start_alma(alma_dir, model_file);
+    }
 }
 
 extern void run() {}
 
 extern void clear()
 {
-    if (!love_number_h) return;
+    /* keep the results of a run nobody asked for yet */
+    if (alma_pid) finish_alma();
 
-    int times = (int)(*p_p) + 1;
-    int t = -1;
-    while (++t < times) {
-        free(love_number_h[t]);
-        free(love_number_k[t]);
-        free(love_number_l[t]);
-    }
     free(love_number_h);  love_number_h = NULL;
     free(love_number_k);  love_number_k = NULL;
     free(love_number_l);  love_number_l = NULL;
+
+    if (love_map) {
+        munmap(love_map, love_map_size);
+        love_map = NULL;
+    }
+    free(love_data);  love_data = NULL;
+
+    free(coef_h);   coef_h  = NULL;
+    free(coef_l);   coef_l  = NULL;
+    free(table_z);  table_z = NULL;
+    free(table_l);  table_l = NULL;
+    table_time  = -1;
+    table_size  = 0;
+    table_alloc = 0;
+}
+
+#define EARTH_RADIUS  6.371e6    /* m  */
+#define EARTH_MASS    5.972e24   /* kg */
+
+#define TABLE_SAMPLES 16         /* table entries per half wavelength of P_deg_max  */
+#define TABLE_CHUNK   256        /* distances per Clenshaw sweep, keeps it in cache */
+
+/*! copies the Love numbers of time index t to coef_h/coef_l, by degree */
+static void set_coefficients(int t)
+{
+    int deg_min  = (int)(*p_deg_min);
+    int deg_max  = (int)(*p_deg_max);
+    int deg_step = (int)(*p_deg_step);
+
+    if (coef_h == NULL) {
+        coef_h = (double*) malloc(sizeof(double) * (deg_max + 1));
+        coef_l = (double*) malloc(sizeof(double) * (deg_max + 1));
+        if (!coef_h || !coef_l) { crusde_bad_alloc(); }
+    }
+
+    memset(coef_h, 0, sizeof(double) * (deg_max + 1));
+    memset(coef_l, 0, sizeof(double) * (deg_max + 1));
+
+    int n, idx;
+    for (n = deg_min, idx = 0; n <= deg_max && idx < love_degrees; n += deg_step, idx++) {
+        if (n < 0) continue;
+        coef_h[n] = (double)love_number_h[t][idx];
+        coef_l[n] = (double)love_number_l[t][idx];
+    }
+
+    /* resolve the oscillation of the highest degree, but never sample coarser than the grid */
+    table_step = crusde_get_gridsize() / EARTH_RADIUS;
+    if (deg_max > 0 && M_PI / (TABLE_SAMPLES * deg_max) < table_step) {
+        table_step = M_PI / (TABLE_SAMPLES * deg_max);
+    }
+}
+
+/*! Clenshaw summation of both series for count distances with cos/sin theta in c/s
+ *
+ *  Vertical:   P_{k+1} = a_k P_k + b_k P_{k-1}, a_k = (2k+1)x/(k+1), b_k = -k/(k+1)
+ *  Horizontal: Q_n = dP_n/dtheta obeys Q_{k+1} = (2k+1)x/k Q_k - (k+1)/k Q_{k-1}
+ *              with Q_0 = 0, Q_1 = -sin theta (the m = 1 associated functions).
+ *  The degree loop is outside, so the inner loop over distances vectorises.
+ */
+static void clenshaw(const double *c, const double *s, double *sum_z, double *sum_l, int count)
+{
+    double buf_z[3][TABLE_CHUNK], buf_l[3][TABLE_CHUNK];
+    double *z0 = buf_z[0], *z1 = buf_z[1], *z2 = buf_z[2];
+    double *l0 = buf_l[0], *l1 = buf_l[1], *l2 = buf_l[2];
+    double *swap;
+    int deg_max = (int)(*p_deg_max);
+    int j, k;
+
+    for (j = 0; j < count; j++) {
+        z1[j] = z2[j] = 0.0;
+        l1[j] = l2[j] = 0.0;
+    }
+
+    for (k = deg_max; k >= 1; k--) {
+        const double az = (2.0*k + 1.0) / (k + 1.0);
+        const double bz = -(k + 1.0) / (k + 2.0);
+        const double al = (2.0*k + 1.0) / k;
+        const double bl = -(k + 2.0) / (k + 1.0);
+        const double h  = coef_h[k];
+        const double l  = coef_l[k];
+
+        for (j = 0; j < count; j++) {
+            z0[j] = h + az * c[j] * z1[j] + bz * z2[j];
+            l0[j] = l + al * c[j] * l1[j] + bl * l2[j];
+        }
+
+        swap = z2; z2 = z1; z1 = z0; z0 = swap;
+        swap = l2; l2 = l1; l1 = l0; l0 = swap;
+    }
+
+    for (j = 0; j < count; j++) {
+        sum_z[j] = coef_h[0] + c[j] * z1[j] - 0.5 * z2[j];
+        sum_l[j] = -s[j] * l1[j];
+    }
+}
+
+/*! computes the table entries up to (excluding) size */
+static void extend_table(int size)
+{
+    if (size > table_alloc) {
+        table_alloc = size > 2 * table_alloc ? size : 2 * table_alloc;
+        table_z = (double*) realloc(table_z, sizeof(double) * table_alloc);
+        table_l = (double*) realloc(table_l, sizeof(double) * table_alloc);
+        if (!table_z || !table_l) { crusde_bad_alloc(); }
+    }
+
+    double c[TABLE_CHUNK], s[TABLE_CHUNK];
+    while (table_size < size) {
+        int count = size - table_size < TABLE_CHUNK ? size - table_size : TABLE_CHUNK;
+        int j;
+        for (j = 0; j < count; j++) {
+            c[j] = cos((table_size + j) * table_step);
+            s[j] = sin((table_size + j) * table_step);
+        }
+        clenshaw(c, s, table_z + table_size, table_l + table_size, count);
+        table_size += count;
+    }
 }
 
 /*! Returns the Green's function value at point (x, y).
@@ -221,6 +545,13 @@ extern void clear()
  *  are loading Love numbers computed by ALMA3.
  *
  *  The time index is taken from crusde_model_step(), clamped to [0, p].
+ *  The first call waits for an ALMA3 run started by init(), if any.
+ *
+ *  Both sums are tabulated over theta (see extend_table()) and interpolated
+ *  with a 4-point Lagrange cubic. The table step resolves P_deg_max with
+ *  TABLE_SAMPLES points per half wavelength; the relative interpolation error
+ *  is of order 1e-5. The table grows with the largest distance requested and
+ *  is rebuilt when the time index changes.
  *
  *  Note: the series is truncated at deg_max.  For accurate near-field results
  *  deg_max should be several hundred or more.
@@ -229,16 +560,15 @@ extern void clear()
  *    Farrell (1972) Deformation of the Earth by surface loads.
  *                  Rev. Geophys. Space Phys. 10(3), 761-797.
  */
-
-#define EARTH_RADIUS  6.371e6    /* m  */
-#define EARTH_MASS    5.972e24   /* kg */
-
 extern int get_value_at(double **result, int x, int y)
 {
     (*result)[x_pos] = 0.0;
     (*result)[y_pos] = 0.0;
     (*result)[z_pos] = 0.0;
 
+    /* Love numbers of a background ALMA3 run */
+    if (alma_pid) finish_alma();
+
     /* Convert grid indices to metres */
     double x_m = x * crusde_get_gridsize();
     double y_m = y * crusde_get_gridsize();
@@ -246,77 +576,37 @@ extern int get_value_at(double **result, int x, int y)
 
     if (r == 0.0) return NOERROR;   /* series diverges at origin */
 
-    /* Angular distance (flat-Earth / small-angle: theta = r/a) */
-    double theta     = r / EARTH_RADIUS;
-    double cos_theta = cos(theta);
-    double sin_theta = sin(theta);
-
     /* Time index: use current model step, clamped to available range */
     int t     = crusde_model_step();
     int t_max = (int)(*p_p);
     if (t > t_max) t = t_max;
 
-    int deg_min  = (int)(*p_deg_min);
-    int deg_max  = (int)(*p_deg_max);
-    int deg_step = (int)(*p_deg_step);
-
-    double sum_z = 0.0;   /* vertical   displacement sum */
-    double sum_h = 0.0;   /* horizontal displacement sum (tangential direction) */
-
-    /*
-     * Legendre polynomial three-term recurrence:
-     *   P_{n+1}(x) = ((2n+1)*x*P_n(x) - n*P_{n-1}(x)) / (n+1)
-     *
-     * At entry to loop iteration n: Pn_prev = P_{n-2}, Pn = P_{n-1}.
-     * Inside iteration: compute P_n, then dP_n/dtheta via:
-     *   dP_n(cos t)/dt = -n * (P_{n-1}(cos t) - cos_t * P_n(cos t)) / sin_t
-     *
-     * For sin_t ≈ 0 use Taylor:  dP_n/dt ≈ -n(n+1)/2 * sin_t
-     */
-
-    /* P_0 = 1, dP_0/dt = 0 */
-    double P0 = 1.0;
-    if (0 >= deg_min && 0 <= deg_max && (0 - deg_min) % deg_step == 0) {
-        int idx = (0 - deg_min) / deg_step;
-        sum_z += (double)love_number_h[t][idx] * P0;
-        /* dP_0/dtheta = 0 */
+    if (t != table_time) {
+        set_coefficients(t);
+        table_time = t;
+        table_size = 0;
     }
 
-    /* P_1 = cos_theta, dP_1/dt = -sin_theta */
-    double P1 = cos_theta;
-    if (1 <= deg_max) {
-        double dP1 = -sin_theta;
-        if (1 >= deg_min && (1 - deg_min) % deg_step == 0) {
-            int idx = (1 - deg_min) / deg_step;
-            sum_z += (double)love_number_h[t][idx] * P1;
-            sum_h += (double)love_number_l[t][idx] * dP1;
-        }
+    /* Angular distance (flat-Earth / small-angle: theta = r/a) in table steps */
+    double u = r / EARTH_RADIUS / table_step;
+    int    i = (int)u;
+    double f = u - i;
+
+    if (i + 3 > table_size) {
+        extend_table((i + 3 + TABLE_CHUNK - 1) / TABLE_CHUNK * TABLE_CHUNK);
     }
 
-    /* n = 2 .. deg_max: compute P_n from P_{n-1} and P_{n-2} */
-    double Pn_prev = P0;
-    double Pn_curr = P1;
-    int n;
-    for (n = 2; n <= deg_max; n++) {
-        double Pn = ((2.0*n - 1.0)*cos_theta*Pn_curr - (n - 1.0)*Pn_prev) / (double)n;
-
-        double dPn;
-        if (sin_theta > 1e-10) {
-            /* dP_n/dt = -n * (P_{n-1} - cos_t * P_n) / sin_t */
-            dPn = -(double)n * (Pn_curr - cos_theta * Pn) / sin_theta;
-        } else {
-            dPn = -(double)n * ((double)n + 1.0) / 2.0 * sin_theta;
-        }
+    /* G_z is even in theta, the derivative series odd */
+    double z_prev = i > 0 ? table_z[i-1] :  table_z[1];
+    double l_prev = i > 0 ? table_l[i-1] : -table_l[1];
 
-        if (n >= deg_min && (n - deg_min) % deg_step == 0) {
-            int idx = (n - deg_min) / deg_step;
-            sum_z += (double)love_number_h[t][idx] * Pn;
-            sum_h += (double)love_number_l[t][idx] * dPn;
-        }
+    double w0 = -f * (f - 1.0) * (f - 2.0) / 6.0;
+    double w1 = (f + 1.0) * (f - 1.0) * (f - 2.0) / 2.0;
+    double w2 = -(f + 1.0) * f * (f - 2.0) / 2.0;
+    double w3 = (f + 1.0) * f * (f - 1.0) / 6.0;
 
-        Pn_prev = Pn_curr;
-        Pn_curr = Pn;
-    }
+    double sum_z = w0*z_prev + w1*table_z[i] + w2*table_z[i+1] + w3*table_z[i+2];
+    double sum_h = w0*l_prev + w1*table_l[i] + w2*table_l[i+1] + w3*table_l[i+2];
 
     /*
      * Scale factor: a/M_E  (Farrell 1972, loading Green's function)
@@ -52,14 +52,6 @@ double shear;
 double sig;
 double eta;
 
-double xx;
-double yy;
-double theta;
-double r;
-int    quadrant;
-short  sin_sign;
-short  cos_sign;
-
 int x_pos, y_pos, z_pos;
 
 double backpack[3];
@@ -68,6 +60,7 @@ extern const char* get_name() 	 { return "elastic halfspace (farrell)"; }
 extern const char* get_version() { return "0.1"; }
 extern const char* get_authors() { return "ronni grapenthin"; }
 extern PluginCategory get_category() { return GREEN_PLUGIN; }
+extern GreenSymmetry get_symmetry()  { return AXIAL_SYMMETRY; }
 extern const char* get_description() { 
 	return "This Green's function implements the 'elastic halfspace' Earth model \
 	case as described by Farrell et al. (1972) for horizontal and vertical displacements."; }
@@ -151,6 +144,60 @@ extern void run(){}
  */
 extern void clear(){}
 
+/*! Green's function at (x+i,y), 0 <= i < n, in the given quadrant, written to u_x[i], u_y[i], u_z[i].
+ *  The direction cosines of the horizontal displacement are |x|/r and |y|/r, signed by the 
+ *  quadrant, the radial term is U_hori(r)/r = -(1 + z/R + eta r^2 z/(shear R^3)) / (4 pi eta r^2). 
+ *  A point costs one sqrt and no other transcendental function. r = 0 gives 0 and is set after the loop, which has no 
+ *  branches then and vectorises.
+ */
+static void values_on_row(double *restrict u_x, double *restrict u_y, double *restrict u_z, int x, int y, int n, int quadrant)
+{
+	double gridsize = crusde_get_gridsize();
+	double yy       = fabs(y*gridsize);
+	double x_hori   = (quadrant == 3 || quadrant == 4 ? -1.0 : 1.0) * -1.0 / (4*PI*eta);
+	double y_hori   = (quadrant == 2 || quadrant == 3 ? -1.0 : 1.0) * -1.0 / (4*PI*eta);
+	double vert     = -1.0 / (4*PI*shear);
+	double depth    = z;
+	double vert_0   = sig/eta;
+	double hori_1   = eta*z/shear;
+	double xx, rr, inv_R, radial;
+	int i;
+
+	for(i = 0; i < n; ++i){
+		xx     = fabs((x+i)*gridsize);
+		rr     = xx*xx + yy*yy;
+		inv_R  = 1.0/sqrt(rr + depth*depth);
+		radial = (1.0 + depth*inv_R + hori_1*rr * inv_R*inv_R*inv_R) / rr;
+
+	/*vertical displacement*/
+		u_z[i] = vert * inv_R * (vert_0 + depth*depth*inv_R*inv_R);
+	/*horizontal displacement*/
+		u_x[i] = x_hori * xx * radial;
+		u_y[i] = y_hori * yy * radial;
+	}
+
+	/* r = 0 gives 0 */
+	if(y == 0 && x <= 0 && x+n > 0){
+		u_x[-x] = u_y[-x] = u_z[-x] = 0.0;
+	}
+}
+
+//! Returns the Green's Function value at Point(x,y) in the given quadrant.
+/*! Reentrant version of get_value_at(), no workspace is needed (see crusde_get_green_at_r()).
+ 
+ * @param workspace Not used, NULL.
+ * @param x The x-Coordinate of the wanted value.
+ * @param y The y-Coordinate of the wanted value.
+ * @param quadrant The quadrant (1-4) the point lies in, gives the direction of the horizontal displacement.
+ * 
+ * @return error code
+ */
+extern int get_value_at_r(void *workspace, double** result, int x, int y, int quadrant)
+{	
+	values_on_row(&(*result)[x_pos], &(*result)[y_pos], &(*result)[z_pos], x, y, 1, quadrant);
+	return NOERROR;
+}
+
 //! Returns the Green's Function value at Point(x,y).
 /*! TODO!
  
@@ -161,52 +208,23 @@ extern void clear(){}
  */
 extern int get_value_at(double** result, int x, int y)
 {	
-	(*result)[x_pos] = 0.0;
-	(*result)[y_pos] = 0.0;
-	(*result)[z_pos] = 0.0;
-	
-	/* CAREFUL! sqrt takes only 'double' and the autocast mechanism lead to weird results, thus do the 
-	 * expansion separately and save it in double typed vars which in turn can be used in the conversion 
-	 * this way using pow(x*gridsize,2) is avoided which is a function call, thus more expensive than 
-	 * a basic operator.*/
-	
-	/* -expand index to a coordinate: x*crusde_get_gridsize() */
-	xx = x*crusde_get_gridsize();
-	yy = y*crusde_get_gridsize();
-		
-	/* -convert carthesian to cylindrical coordinates: r = srqt(x^2+y^2)*/
-	double r = sqrt(xx*xx + yy*yy);
-    double R = sqrt(r*r   + z*z);
-	
-	if(r>0){
-	/*vertical displacement*/
-        (*result)[z_pos]    = -1/(4*PI*shear*R) * (sig/eta + (z*z)/(R*R));
-        U_hori_const        = -1/(4*PI*eta*r)   * (1      +z/R        +(eta*r*r*z)/(shear*R*R*R));
-	/*horizontal displacement*/
-		quadrant = crusde_get_quadrant();
-		sin_sign = 1;
-		cos_sign = 1;
-		
-		/* get the angle of the cyllindrical coordinate */
-		if(xx == 0){	theta=PI/2;		}
-		else{           theta = atan(fabs(yy)/fabs(xx));}
-		
-		/* get the direction of the direction cosine */
-		if(quadrant==2){	
-			sin_sign = -1;
-		}
-		else if(quadrant==3){	
-			sin_sign = -1;
-			cos_sign = -1;
-		}
-		else if(quadrant==4){	
-			cos_sign = -1;
-		}
-			
-	/*horizontal displacement*/
-		(*result)[x_pos] = (cos_sign * cos(theta) * U_hori_const);
-		(*result)[y_pos] = (sin_sign * sin(theta) * U_hori_const);
-	}
-	
+	return get_value_at_r(NULL, result, x, y, crusde_get_quadrant());
+}
+
+//! Returns the Green's Function values at the Points (x+i,y), 0 <= i < n, in the given quadrant.
+/*! Row evaluator for crusde_get_green_row_at(), row[x_pos], row[y_pos] and row[z_pos] receive 
+ *  n values each. Reentrant, no workspace is needed.
+ 
+ * @param workspace Not used, NULL.
+ * @param x The x-Coordinate of the first value.
+ * @param y The y-Coordinate of the row.
+ * @param n The number of values.
+ * @param quadrant The quadrant (1-4) the points lie in, gives the direction of the horizontal displacement.
+ * 
+ * @return error code
+ */
+extern int get_row_at(void *workspace, double** row, int x, int y, int n, int quadrant)
+{
+	values_on_row(row[x_pos], row[y_pos], row[z_pos], x, y, n, quadrant);
 	return NOERROR;
 }
@@ -0,0 +1,263 @@
+/***************************************************************************
+ * File:        ./plugins/green/hs_spectrum.c
+ * Author:      agent
+ * Created:     17.10.2026
+ * Licence:     GPL
+ ****************************************************************************/
+
+/**
+ *  @ingroup GreensFunction
+ */
+ /*@{*/
+/** \file hs_spectrum.c
+ *
+ * Closed form spectrum of the elastic halfspace, i.e. of the Green's functions
+ * \f[
+ *	G_{z}(r)  = \frac{U_{z,const}}{r}, \qquad G_{r}(r)  = \frac{U_{r,const}}{r}
+ * \f]
+ * sampled on the model grid and truncated to a disk. The plugins of this form export 
+ * get_spectrum_at() by passing their constants to hs_spectrum_at(). This is not a plugin, 
+ * the object file is linked into each plugin library (see Makefile), so every plugin 
+ * keeps tables of its own.
+ */
+/*@}*/
+
+#include <stdlib.h>
+#include <math.h>
+#include <gsl/gsl_sf_bessel.h>
+#include "crusde_api.h"
+#include "hs_spectrum.h"
+
+#define ALIAS_STEPS 64		/*steps of the alias tables over 0 <= q <= pi*/
+#define ALIAS_TERMS 16		/*aliases summed in each direction*/
+#define BESSEL_STEP 0.1		/*distance of the nodes of the J0 tables*/
+
+static double *alias_z = NULL;		//!< aliases of the spectrum of 1/r, see alias_tables()
+static double *alias_r = NULL;		//!< aliases of the spectrum of x/r^2, see alias_tables()
+static double *bessel_j0 = NULL;	//!< J0 at the nodes k*BESSEL_STEP
+static double *bessel_j1 = NULL;	//!< J1 at the nodes
+static double *bessel_int = NULL;	//!< integral of J0 from 0 to the nodes
+static int bessel_nodes = 0;		//!< number of nodes tabulated
+
+/*! sin(a)/a*/
+static double sinc(double a)
+{
+	return (a == 0.0 ? 1.0 : sin(a)/a);
+}
+
+//! Tabulates the aliases of the spectrum.
+/*! For 0 <= q_x, q_y <= pi the tables hold the sums over all aliases m != 0 of the cell-averaged 
+ *  transforms of 1/r and x/r^2, with p = q + 2*pi*m:
+ * \f[
+ *	Z(q)  = \sum_{m \neq 0} s(p) \frac{2\pi}{|p|}, \qquad X(q)  = \sum_{m \neq 0} s(p) \frac{2\pi p_x}{|p|^2}
+ * \f]
+ *  They do not depend on any parameter. s(p) alternates in sign with m, the last terms of the 
+ *  truncated sums are halved.
+ */
+static void alias_tables()
+{
+	int i, j, mx, my;
+	double qx, qy, px, py, p2, weight, sum_z, sum_r;
+
+	alias_z = (double*) malloc(sizeof(double) * (ALIAS_STEPS+1) * (ALIAS_STEPS+1));
+	alias_r = (double*) malloc(sizeof(double) * (ALIAS_STEPS+1) * (ALIAS_STEPS+1));
+
+	if(alias_z == NULL || alias_r == NULL){
+		crusde_bad_alloc();
+	}
+
+	for(j = 0; j <= ALIAS_STEPS; ++j){
+		for(i = 0; i <= ALIAS_STEPS; ++i){
+			qx = PI * i / ALIAS_STEPS;
+			qy = PI * j / ALIAS_STEPS;
+			sum_z = 0.0;
+			sum_r = 0.0;
+
+			for(my = -ALIAS_TERMS; my <= ALIAS_TERMS; ++my){
+				for(mx = -ALIAS_TERMS; mx <= ALIAS_TERMS; ++mx){
+					if(mx == 0 && my == 0){
+						continue;
+					}
+
+					px = qx + 2.0*PI*mx;
+					py = qy + 2.0*PI*my;
+					p2 = px*px + py*py;
+					weight = sinc(px/2.0) * sinc(py/2.0) 
+					       * (abs(mx) == ALIAS_TERMS ? 0.5 : 1.0) * (abs(my) == ALIAS_TERMS ? 0.5 : 1.0);
+
+					sum_z += weight * 2.0*PI / sqrt(p2);
+					sum_r += weight * 2.0*PI * px / p2;
+				}
+			}
+
+			alias_z[i + (ALIAS_STEPS+1)*j] = sum_z;
+			alias_r[i + (ALIAS_STEPS+1)*j] = sum_r;
+		}
+	}
+}
+
+/*! bilinear interpolation of an alias table at 0 <= qx, qy <= pi*/
+static double alias_at(double *table, double qx, double qy)
+{
+	double u = qx / PI * ALIAS_STEPS;
+	double v = qy / PI * ALIAS_STEPS;
+	int i = (int) u;
+	int j = (int) v;
+
+	if(i >= ALIAS_STEPS){ i = ALIAS_STEPS-1; }
+	if(j >= ALIAS_STEPS){ j = ALIAS_STEPS-1; }
+	u -= i;
+	v -= j;
+
+	return (1.0-u) * (1.0-v) * table[i   + (ALIAS_STEPS+1)*j]
+	     +      u  * (1.0-v) * table[i+1 + (ALIAS_STEPS+1)*j]
+	     + (1.0-u) *      v  * table[i   + (ALIAS_STEPS+1)*(j+1)]
+	     +      u  *      v  * table[i+1 + (ALIAS_STEPS+1)*(j+1)];
+}
+
+//! J0(x) and its integral from 0 to x.
+/*! Both are interpolated by cubic Hermite polynomials between nodes BESSEL_STEP apart, using 
+ *  J0' = -J1 and the J0 itself as derivatives. The nodes are added as larger x are requested, 
+ *  the integral over each new interval is done by 4-point Gauss-Legendre quadrature.
+ */
+static void bessel_at(double x, double *j0, double *int_j0)
+{
+	static const double node[2]   = { 0.339981043584856, 0.861136311594053 };
+	static const double weight[2] = { 0.652145154862546, 0.347854845137454 };
+	int n = (int) (x / BESSEL_STEP);
+	int nodes, k, i;
+	double t, h00, h10, h01, h11, mid;
+
+	if(n+2 > bessel_nodes){
+		nodes = 2*(n+2);
+
+		bessel_j0  = (double*) realloc(bessel_j0,  sizeof(double) * nodes);
+		bessel_j1  = (double*) realloc(bessel_j1,  sizeof(double) * nodes);
+		bessel_int = (double*) realloc(bessel_int, sizeof(double) * nodes);
+
+		if(bessel_j0 == NULL || bessel_j1 == NULL || bessel_int == NULL){
+			crusde_bad_alloc();
+		}
+
+		for(k = bessel_nodes; k < nodes; ++k){
+			bessel_j0[k] = gsl_sf_bessel_J0(k*BESSEL_STEP);
+			bessel_j1[k] = gsl_sf_bessel_J1(k*BESSEL_STEP);
+
+			if(k == 0){
+				bessel_int[k] = 0.0;
+				continue;
+			}
+
+			mid = (k-0.5) * BESSEL_STEP;
+			bessel_int[k] = 0.0;
+			for(i = 0; i < 2; ++i){
+				bessel_int[k] += weight[i] * ( gsl_sf_bessel_J0(mid - node[i]*BESSEL_STEP/2.0) 
+				                             + gsl_sf_bessel_J0(mid + node[i]*BESSEL_STEP/2.0) );
+			}
+			bessel_int[k] = bessel_int[k-1] + bessel_int[k] * BESSEL_STEP/2.0;
+		}
+
+		bessel_nodes = nodes;
+	}
+
+	t   = x / BESSEL_STEP - n;
+	h00 = (1.0 + 2.0*t) * (1.0-t) * (1.0-t);
+	h10 = t * (1.0-t) * (1.0-t);
+	h01 = t * t * (3.0 - 2.0*t);
+	h11 = t * t * (t - 1.0);
+
+	*j0     = h00 * bessel_j0[n]  - h10 * BESSEL_STEP * bessel_j1[n] + h01 * bessel_j0[n+1]  - h11 * BESSEL_STEP * bessel_j1[n+1];
+	*int_j0 = h00 * bessel_int[n] + h10 * BESSEL_STEP * bessel_j0[n] + h01 * bessel_int[n+1] + h11 * BESSEL_STEP * bessel_j0[n+1];
+}
+
+//! Returns the spectrum of the halfspace Green's function at wavenumber (kx,ky).
+/*! The Green's function of the model grid is G_z, G_r averaged over each grid cell, 
+ *  truncated to the disk of the given radius. Its 2D discrete Fourier transform is the 
+ *  continuous transform of the cell-averaged function summed over all aliases k + 2*pi*m/gridsize. 
+ *  With q = k*gridsize, s(q) = sinc(q_x/2)*sinc(q_y/2) for the cell average, and R the radius, the 
+ *  alias m = 0 is
+ * \f[
+ *	\hat{G}_{z}(q)  = \frac{U_{z,const}}{gridsize} \, s(q) \frac{2\pi}{|q|} \int_0^{kR} J_0(t) dt
+ * \f]
+ * \f[
+ *	\hat{G}_{x}(q)  = -i \frac{U_{r,const}}{gridsize} \, s(q) \frac{2\pi q_x}{|q|^2} (1 - J_0(kR))
+ * \f]
+ *  and the other aliases add, with the truncation dropped, the functions of q tabulated by 
+ *  alias_tables(). At r = 0 this gives the cell average of 1/r rather than the 0 of 
+ *  the plugins' get_value_at(). The relative error is about 1e-5.
+ * 
+ * @param re, im Real and imaginary parts of the spectrum.
+ * @param kx, ky Wavenumber [rad/m], |kx|, |ky| <= pi/gridsize.
+ * @param radius Radius of the disk the Green's function is truncated to [m].
+ * @param vert_const, hori_const U_{z,const} and U_{r,const}.
+ * @param x_pos, y_pos, z_pos Positions of the components in re and im.
+ * 
+ * @return error code
+ */
+int hs_spectrum_at(double** re, double** im, double kx, double ky, double radius, 
+                   double vert_const, double hori_const, int x_pos, int y_pos, int z_pos)
+{
+	double dx = crusde_get_gridsize();
+	double qx = kx*dx;
+	double qy = ky*dx;
+	double q2 = qx*qx + qy*qy;
+	double q  = sqrt(q2);
+	double s  = sinc(qx/2.0) * sinc(qy/2.0);
+	double j0, int_j0;
+	double radial;
+
+	if(alias_z == NULL){
+		alias_tables();
+	}
+
+	/*alias m = 0, limit for k -> 0: 2*pi*radius/gridsize and 0*/
+	if(q > 0.0){
+		bessel_at(q/dx * radius, &j0, &int_j0);
+
+		(*re)[z_pos] = s * 2.0*PI / q * int_j0;
+		radial       = s * 2.0*PI / q2 * (1.0 - j0);
+	}
+	else{
+		(*re)[z_pos] = 2.0*PI * radius / dx;
+		radial       = 0.0;
+	}
+
+	/*all other aliases*/
+	(*re)[z_pos] += alias_at(alias_z, fabs(qx), fabs(qy));
+	(*re)[z_pos] *= vert_const / dx;
+	(*im)[z_pos]  = 0.0;
+
+	(*re)[x_pos] = 0.0;
+	(*re)[y_pos] = 0.0;
+
+	/*the horizontal components are odd, at the Nyquist frequency their transform vanishes*/
+	if(fabs(qx) < PI*(1.0 - 1e-12)){
+		(*im)[x_pos] = -hori_const / dx * ( radial*qx + (qx < 0.0 ? -1.0 : 1.0) * alias_at(alias_r, fabs(qx), fabs(qy)) );
+	}
+	else{
+		(*im)[x_pos] = 0.0;
+	}
+
+	if(fabs(qy) < PI*(1.0 - 1e-12)){
+		(*im)[y_pos] = -hori_const / dx * ( radial*qy + (qy < 0.0 ? -1.0 : 1.0) * alias_at(alias_r, fabs(qy), fabs(qx)) );
+	}
+	else{
+		(*im)[y_pos] = 0.0;
+	}
+
+	return NOERROR;
+}
+
+//! Frees the tables of hs_spectrum_at(), called from the clear() of the plugins.
+void hs_spectrum_clear()
+{
+	free(alias_z);
+	free(alias_r);
+	free(bessel_j0);
+	free(bessel_j1);
+	free(bessel_int);
+
+	alias_z = alias_r = NULL;
+	bessel_j0 = bessel_j1 = bessel_int = NULL;
+	bessel_nodes = 0;
+}
@@ -0,0 +1,30 @@
+/***************************************************************************
+ * File:        ./plugins/green/hs_spectrum.h
+ * Author:      agent
+ * Created:     17.10.2026
+ * Licence:     GPL
+ ****************************************************************************/
+
+/**
+ *  @ingroup GreensFunction
+ */
+ /*@{*/
+/** \file hs_spectrum.h
+ *
+ * Closed form spectrum of the elastic halfspace, shared by the Green's function plugins
+ * whose displacements go with 1/r (pinel_hs_elastic.c, boussinesq_hs_elastic.c). This is 
+ * not a plugin, the object file is linked into each plugin library (see Makefile).
+ */
+/*@}*/
+
+#ifndef _hs_spectrum_h
+#define _hs_spectrum_h
+
+/* spectrum of G_z = vert_const/r, G_r = hori_const/r truncated to a disk, see hs_spectrum.c */
+int	hs_spectrum_at(double** re, double** im, double kx, double ky, double radius, 
+	               double vert_const, double hori_const, int x_pos, int y_pos, int z_pos);
+
+/* frees the tables of hs_spectrum_at() */
+void	hs_spectrum_clear();
+
+#endif
@@ -26,8 +26,11 @@
  *  The sequence in which the functions are called from the main program is as follows:
  *  -# register_parameter()
  *  -# init()
- *  -# get_value_at(int, int, int)
+ *  -# get_value_at(int, int, int) and/or get_spectrum_at()
  *  -# clear()
+ *
+ * get_spectrum_at() gives the spectrum of the Green's function in closed form, which 
+ * convolution operators in the frequency domain use instead of transforming sampled values.
  */
 /*@}*/
 
@@ -35,6 +38,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include "crusde_api.h"
+#include "hs_spectrum.h"
 
 double* p_g;		//!< gravity 		[m/s^2]
 double* p_E;		//!< Young's Modulus 	[GPa]	
@@ -47,14 +51,6 @@ double nu;		//!< Poisson's ratio 	[-]
 double U_vert_const;	//!< Constant part of the vertical displacement equation 
 double U_hori_const;	//!< Constant part of the horizontal displacement equation 
 
-double xx;
-double yy;
-double theta;
-double r;
-int quadrant;
-short sin_sign;
-short cos_sign;
-
 int x_pos, y_pos, z_pos;
 
 double backpack[3];
@@ -63,6 +59,7 @@ extern const char* get_name() 	 { return "elastic halfspace (pinel)"; }
 extern const char* get_version() { return "0.1"; }
 extern const char* get_authors() { return "ronni grapenthin"; }
 extern PluginCategory get_category() { return GREEN_PLUGIN; }
+extern GreenSymmetry get_symmetry()  { return AXIAL_SYMMETRY; }
 extern const char* get_description() { 
 	return "This Green's function implements the 'elastic halfspace' Earth model \
 	case as described by Pinel et al. (2006) for horizontal and vertical displacement: \
@@ -145,9 +142,60 @@ extern void init()
 extern void run(){}
 
 //! Clean-up before this plug-in gets unloaded. 
-/*! Yet, there is nothing to free here.
+/*! Frees the tables of get_spectrum_at().
+ */
+extern void clear()
+{
+	hs_spectrum_clear();
+}
+
+/*! Green's function at (x+i,y), 0 <= i < n, in the given quadrant, written to u_x[i], u_y[i], u_z[i].
+ *  The direction cosines of the horizontal displacement are |x|/r and |y|/r, signed by the 
+ *  quadrant, so a point costs one sqrt and no other transcendental function. r = 0 gives 0 and 
+ *  is set after the loop, which has no branches then and vectorises.
  */
-extern void clear(){}
+static void values_on_row(double *restrict u_x, double *restrict u_y, double *restrict u_z, int x, int y, int n, int quadrant)
+{
+	double gridsize = crusde_get_gridsize();
+	double yy       = fabs(y*gridsize);
+	double x_hori   = (quadrant == 3 || quadrant == 4 ? -1.0 : 1.0) * U_hori_const;
+	double y_hori   = (quadrant == 2 || quadrant == 3 ? -1.0 : 1.0) * U_hori_const;
+	double vert     = U_vert_const;
+	double xx, inv_r;
+	int i;
+
+	for(i = 0; i < n; ++i){
+		xx    = fabs((x+i)*gridsize);
+		inv_r = 1.0/sqrt(xx*xx + yy*yy);
+
+	/*vertical displacement*/
+		u_z[i] = vert * inv_r;
+	/*horizontal displacement*/
+		u_x[i] = x_hori * xx * inv_r*inv_r;
+		u_y[i] = y_hori * yy * inv_r*inv_r;
+	}
+
+	/* r = 0 gives 0 */
+	if(y == 0 && x <= 0 && x+n > 0){
+		u_x[-x] = u_y[-x] = u_z[-x] = 0.0;
+	}
+}
+
+//! Returns the Green's Function value at Point(x,y) in the given quadrant.
+/*! Reentrant version of get_value_at(), no workspace is needed (see crusde_get_green_at_r()).
+ 
+ * @param workspace Not used, NULL.
+ * @param x The x-Coordinate of the wanted value.
+ * @param y The y-Coordinate of the wanted value.
+ * @param quadrant The quadrant (1-4) the point lies in, gives the direction of the horizontal displacement.
+ * 
+ * @return error code
+ */
+extern int get_value_at_r(void *workspace, double** result, int x, int y, int quadrant)
+{	
+	values_on_row(&(*result)[x_pos], &(*result)[y_pos], &(*result)[z_pos], x, y, 1, quadrant);
+	return NOERROR;
+}
 
 //! Returns the Green's Function value at Point(x,y).
 /*! TODO!
@@ -159,50 +207,38 @@ extern void clear(){}
  */
 extern int get_value_at(double** result, int x, int y)
 {	
-	(*result)[x_pos] = 0.0;
-	(*result)[y_pos] = 0.0;
-	(*result)[z_pos] = 0.0;
-	
-	/* CAREFUL! sqrt takes only 'double' and the autocast mechanism lead to weird results, thus do the 
-	 * expansion separately and save it in double typed vars which in turn can be used in the conversion 
-	 * this way using pow(x*gridsize,2) is avoided which is a function call, thus more expensive than 
-	 * a basic operator.*/
-	
-	/* -expand index to a coordinate: x*crusde_get_gridsize() */
-	xx = x*crusde_get_gridsize();
-	yy = y*crusde_get_gridsize();
-		
-	/* -convert carthesian to cylindrical coordinates: r = srqt(x^2+y^2)*/
-	double r = sqrt(xx*xx + yy*yy);
-	
-	if(r>0){
-	/*vertical displacement*/
-		(*result)[z_pos] = (U_vert_const / r);
-	/*horizontal displacement*/
-		quadrant = crusde_get_quadrant();
-		sin_sign = 1;
-		cos_sign = 1;
-		
-		/* get the angle of the cyllindrical coordinate */
-		if(xx == 0){	theta=PI/2;		}
-		else{		theta = atan(fabs(yy)/fabs(xx));}
-		
-		/* get the direction of the direction cosine */
-		if(quadrant==2){	
-			sin_sign = -1;
-		}
-		else if(quadrant==3){	
-			sin_sign = -1;
-			cos_sign = -1;
-		}
-		else if(quadrant==4){	
-			cos_sign = -1;
-		}
-			
-	/*horizontal displacement*/
-		(*result)[x_pos] = (cos_sign * cos(theta) * U_hori_const / r);
-		(*result)[y_pos] = (sin_sign * sin(theta) * U_hori_const / r);
-	}
-	
+	return get_value_at_r(NULL, result, x, y, crusde_get_quadrant());
+}
+
+//! Returns the Green's Function values at the Points (x+i,y), 0 <= i < n, in the given quadrant.
+/*! Row evaluator for crusde_get_green_row_at(), row[x_pos], row[y_pos] and row[z_pos] receive 
+ *  n values each. Reentrant, no workspace is needed.
+ 
+ * @param workspace Not used, NULL.
+ * @param x The x-Coordinate of the first value.
+ * @param y The y-Coordinate of the row.
+ * @param n The number of values.
+ * @param quadrant The quadrant (1-4) the points lie in, gives the direction of the horizontal displacement.
+ * 
+ * @return error code
+ */
+extern int get_row_at(void *workspace, double** row, int x, int y, int n, int quadrant)
+{
+	values_on_row(row[x_pos], row[y_pos], row[z_pos], x, y, n, quadrant);
 	return NOERROR;
 }
+
+//! Returns the spectrum of the Green's function at wavenumber (kx,ky).
+/*! The spectrum of the Green's function sampled on the model grid and truncated to the disk
+ *  of the given radius, in closed form, see hs_spectrum_at().
+ * 
+ * @param re, im Real and imaginary parts of the spectrum.
+ * @param kx, ky Wavenumber [rad/m], |kx|, |ky| <= pi/gridsize.
+ * @param radius Radius of the disk the Green's function is truncated to [m].
+ * 
+ * @return error code
+ */
+extern int get_spectrum_at(double** re, double** im, double kx, double ky, double radius)
+{	
+	return hs_spectrum_at(re, im, kx, ky, radius, U_vert_const, U_hori_const, x_pos, y_pos, z_pos);
+}
@@ -31,6 +31,7 @@ extern const char* get_name() 	 { return "elastic minus thickplate (pinel)"; }
 extern const char* get_version() { return "0.1"; }
 extern const char* get_authors() { return "ronni grapenthin"; }
 extern PluginCategory get_category() { return GREEN_PLUGIN; }
+extern GreenSymmetry get_symmetry()  { return AXIAL_SYMMETRY; }
 extern const char* get_description() { return ""; }
 
 //! Register parameters this Green's function claims from the input.
@@ -48,8 +48,17 @@
  * where c\epsilon\f$ is the variable of integration. If \f$H \to \infty\f$, then \f$\frac{A}{D} \to -\frac{2\nu}{\epsilon}\f$ and 
  * \f$\frac{A}{D} \to 1\f$ which gives the solution of the elastic half-space.
  *
- * The Hankel transform integral is calculated in the bounds \f$\[0 .. 0.003\]\f$ using gsl_integration_qag of the 
+ * The Hankel transform integral is calculated in the bounds \f$\[0 .. 0.003\]\f$ by composite Gauss-Legendre 
+ * quadrature. The epsilon dependent parts of the integrands do not depend on r; they are tabulated once 
+ * per parameter set on the quadrature nodes and shared by all radii. The nodes form levels of 
+ * 2^l panels, each radius uses the coarsest level whose panels are no longer than two periods of 
+ * \f$J_{0,1}(\epsilon r)\f$ (relative error below 1e-7). Results are kept per squared grid distance \f$x^2+y^2\f$, such that points at 
+ * the same distance (e.g. (x,y) and (y,x)) are integrated once. The Bessel functions are those of the 
  * GNU Scientific Library (http://www.gnu.org/software/gsl/).
+ *
+ * get_value_at_r() is reentrant: each thread keeps its results in a workspace of its own 
+ * (new_workspace()), the tables of the integrands are shared and only read. new_workspace() tabulates 
+ * the levels the operator space needs, radii beyond that are integrated without the tables.
 */
 /*@}*/
 
@@ -59,12 +68,11 @@
 
 //gnu scientific lib includes
 #include <gsl/gsl_sf_bessel.h>
-#include <gsl/gsl_integration.h>
-#include <gsl/gsl_statistics_double.h>
 
 #include "crusde_api.h"
 
-#define SIZE_W		100000
+#define GL_ORDER	16	//!< Gauss-Legendre nodes per panel
+#define MAX_LEVEL	24	//!< maximum number of node levels, level l has base_panels*2^l panels
 
 double *p_g;		//!< gravity 				[m/s^2]
 double *p_E;		//!< Young's Modulus 			[GPa]	
@@ -81,147 +89,289 @@ double H;		//!< thickness of the elastic plate	[m]
 double U_vert_const;	//!< Constant part of the vertical displacement equation 
 double U_hori_const;	//!< Constant part of the horizontal displacement equation 
 
-double xx                   = 0.0;
-double yy                   = 0.0;	
-double theta                = 0.0;
-double r                    = 0.0;
-double local_r              = 0.0;
-double result_j0            = -1.0;
-double result_j1            = -1.0;
-double error                = 0.0;
-int quadrant                = -1;
-short sin_sign              = -23;
-short cos_sign              = -23;
-double one_minus_nu_squared = 0.0;
-double H_squared            = 0.0;
-double H2                   = 0.0;
-double g_rho_f_E_term       = 0.0;
-double g_rho_f_E_term2      = 0.0;
-double nu4                  = 0.0;
-double sin_h                = 0.0;
-double cos_h                = 0.0;
-double A, B, D;
-double global_e             = 0.0;
-
 int x_pos, y_pos, z_pos;
 
-gsl_integration_workspace * w = NULL;
-gsl_function j0_integral;
-gsl_function j1_integral;
-/*gsl_function init_h_LUT;
-gsl_function init_v_LUT;
-*/	
-//double *LUT_vertical, *LUT_horizontal;
 double lower_integral_bound, upper_integral_bound;
-//int eps_index = 0;
 
-int i=0;
-//double lower_bound=0.0;
-//double upper_bound=0.0;
-//double sum_r=0.0;
-//double sum_z=0.0;
-//double v[10];
-//double vH[10];
-//int nc=0;
+/* Gauss-Legendre nodes and weights on [-1,1] */
+double gl_node[GL_ORDER];
+double gl_weight[GL_ORDER];
+
+/* tabulated integrands without the Bessel function, weights included, one set per level */
+int     base_panels = 0;		//!< panels of level 0, resolve the epsilon dependence of the kernel
+double *level_eps[MAX_LEVEL];	//!< quadrature nodes epsilon
+double *level_j0[MAX_LEVEL];	//!< weight * (B/D - 1)
+double *level_j1[MAX_LEVEL];	//!< weight * (1-nu^2)(2 epsilon A/D + 4 nu)
+
+/* Hankel transforms computed so far, open addressing by squared grid distance */
+typedef struct {
+	long   *key;		//!< squared grid distance, -1: empty slot
+	double *j0;
+	double *j1;
+	long    size;		//!< number of slots, a power of 2
+	long    count;		//!< number of occupied slots
+} memo_table;
+
+memo_table memo = { NULL, NULL, NULL, 0, 0 };	//!< memo of get_value_at(), workspaces have their own
 
 /*local functions*/
 
 //--------------------------------------------------------------
 
-/*initializes lookup-table for vertical and horizontal integral functions*/
-/*double init_vertical_LUT(double e, void *params)
+/*! Gauss-Legendre nodes and weights of order n on [-1,1], by Newton iteration on P_n */
+static void gauss_legendre(int n, double *node, double *weight)
 {
-	sin_h = sinh(2*e*H);
-	cos_h = cosh(2*e*H);
+	int i, k;
+	double z, z_old, p0, p1, p2, dp;
+
+	for(i = 0; i < (n+1)/2; ++i){
+		z = cos(PI * (i + 0.75) / (n + 0.5));
+		do{
+			p0 = 1.0;
+			p1 = 0.0;
+			for(k = 1; k <= n; ++k){
+				p2 = p1;
+				p1 = p0;
+				p0 = ((2.0*k - 1.0) * z * p1 - (k - 1.0) * p2) / k;
+			}
+			dp    = n * (z*p0 - p1) / (z*z - 1.0);
+			z_old = z;
+			z     = z_old - p0/dp;
+		}while(fabs(z - z_old) > 1.0e-15);
+
+		node[i]        = -z;
+		node[n-1-i]    =  z;
+		weight[i]      = 2.0 / ((1.0 - z*z) * dp*dp);
+		weight[n-1-i]  = weight[i];
+	}
+}
 
-	//constants from Pinel et.al. (2007)
+/*! (B/D - 1) and (1-nu^2)(2 e A/D + 4 nu) at epsilon e, constants from Pinel et.al. (2007)*/
+static void kernel_at(double e, double *k_j0, double *k_j1)
+{
+	double sin_h = sinh(2.0*e*H);
+	double cos_h = cosh(2.0*e*H);
+	double A, B, D;
+
+	A = e*e*H*H - nu*(cos_h-1.0) - ( (2.0 * (1.0-nu*nu)) / E ) * g*rho_f*(nu*(sin_h/e)+H); 
 	B = 0.5*e*sin_h + e*e*H + ( (1.0-nu*nu)/E )*g*rho_f*(cos_h-1.0); 
 	D = -1.0*e*e*e*H*H + 0.5*e*(cos_h-1.0) + ( (1.0-nu*nu)/E )*g*rho_f*(sin_h+2.0*e*H); 
 
-	if(D!=0){
-		LUT_vertical[eps_index] = B/D - 1.0;
+	if(D!=0.0){
+		*k_j0 = B/D - 1.0;
+		*k_j1 = (1.0-nu*nu)*(2.0*e*A/D + nu*4.0);
 	}
 	else{
-		LUT_vertical[eps_index] = 0.0;
+		*k_j0 = 0.0;
+		*k_j1 = 0.0;
 	}
-	local_r = *((double *) params);	
-	
-	return ( LUT_vertical[eps_index++] * gsl_sf_bessel_J0(e*local_r) ) ;
-
 }
-*/
-/*
-double init_horizontal_LUT(double e, void *params)
+
+/*! tabulates the integrands on the nodes of level l, i.e. base_panels*2^l panels */
+static void init_level(int l)
 {
-	sin_h = sinh(2*e*H);
-	cos_h = cosh(2*e*H);
+	int panels = base_panels << l;
+	double h = (upper_integral_bound - lower_integral_bound) / panels;
+	int p, i, n;
 
-	//constants from Pinel et.al. (2007)
-	A = e*e*H*H - nu*(cos_h-1.0) - ( (2.0 * (1.0-nu*nu)) / E ) * g*rho_f*(nu*(sin_h/e)+H); 
-	D = -1.0*e*e*e*H*H + 0.5*e*(cos_h-1.0) + ( (1.0-nu*nu)/E )*g*rho_f*(sin_h+2.0*e*H); 
+	level_eps[l] = (double*) malloc(sizeof(double) * panels * GL_ORDER);
+	level_j0[l]  = (double*) malloc(sizeof(double) * panels * GL_ORDER);
+	level_j1[l]  = (double*) malloc(sizeof(double) * panels * GL_ORDER);
 
-	if(D!=0){
-		LUT_horizontal[eps_index] =  (1-nu*nu)*(2.0*e*A/D + nu*4.0);
+	if(level_eps[l] == NULL || level_j0[l] == NULL || level_j1[l] == NULL){
+		crusde_bad_alloc();
 	}
-	else{
-		LUT_horizontal[eps_index] 	= 0.0;
+
+	for(p = 0; p < panels; ++p){
+		for(i = 0; i < GL_ORDER; ++i){
+			n = p*GL_ORDER + i;
+			level_eps[l][n] = lower_integral_bound + h*(p + 0.5*(gl_node[i] + 1.0));
+			kernel_at(level_eps[l][n], &level_j0[l][n], &level_j1[l][n]);
+			level_j0[l][n] *= 0.5*h*gl_weight[i];
+			level_j1[l][n] *= 0.5*h*gl_weight[i];
+		}
 	}
-	
-	local_r = *((double *) params);	
-	
-	return ( LUT_horizontal[eps_index++] *  gsl_sf_bessel_J1(e*local_r) ) ;
+}
+
+/*! coarsest level that resolves J(epsilon r) at radius r [m] */
+static int level_at(double r)
+{
+	int l = 0;
 
+	/* panels no longer than two periods 2 pi / r of the Bessel functions, 8 nodes per period */
+	while(l < MAX_LEVEL-1 && (upper_integral_bound - lower_integral_bound) / (base_panels << l) * r > 4.0*PI){
+		++l;
+	}
+	return l;
 }
-*/
 
-double zeroth_order_bessel_integral(double e, void *params)
+/*! both Hankel transforms at radius r [m] on level l, evaluating the integrands on the fly, reentrant */
+static void hankel_untabulated(int l, double r, double *int_j0, double *int_j1)
 {
-	//cast and dereference
-	local_r = *((double *) params);
-	sin_h = sinh(2*e*H);
-	cos_h = cosh(2*e*H);
+	int panels = base_panels << l;
+	double h = (upper_integral_bound - lower_integral_bound) / panels;
+	double e, k_j0, k_j1, sum_j0 = 0.0, sum_j1 = 0.0;
+	int p, i;
+
+	for(p = 0; p < panels; ++p){
+		for(i = 0; i < GL_ORDER; ++i){
+			e = lower_integral_bound + h*(p + 0.5*(gl_node[i] + 1.0));
+			kernel_at(e, &k_j0, &k_j1);
+			sum_j0 += 0.5*h*gl_weight[i] * k_j0 * gsl_sf_bessel_J0(e*r);
+			sum_j1 += 0.5*h*gl_weight[i] * k_j1 * gsl_sf_bessel_J1(e*r);
+		}
+	}
 
-	/* constants from Pinel et.al. (2007)*/	
-	B = 0.5*e*sin_h + e*e*H + ( (1.0-nu*nu)/E )*g*rho_f*(cos_h-1.0); 
-	D = -1.0*e*e*e*H*H + 0.5*e*(cos_h-1.0) + ( (1.0-nu*nu)/E )*g*rho_f*(sin_h+2.0*e*H); 
+	*int_j0 = sum_j0;
+	*int_j1 = sum_j1;
+}
 
-	if(D!=0){
-		return (B/D - 1.0 ) * gsl_sf_bessel_J0(e*local_r);
+/*! both Hankel transforms at radius r [m], on the coarsest level that resolves J(epsilon r) 
+ *  A level that is not tabulated yet is tabulated if 'tabulate' is set, otherwise (reentrant 
+ *  use) the integrands are evaluated on the fly.
+ */
+static void hankel_transforms(double r, double *int_j0, double *int_j1, int tabulate)
+{
+	int l = level_at(r), n, nodes;
+	double sum_j0 = 0.0, sum_j1 = 0.0;
+
+	if(level_eps[l] == NULL){
+		if(!tabulate){
+			hankel_untabulated(l, r, int_j0, int_j1);
+			return;
+		}
+		init_level(l);
 	}
-	else{
-		return 0.0;
+
+	nodes = (base_panels << l) * GL_ORDER;
+	for(n = 0; n < nodes; ++n){
+		sum_j0 += level_j0[l][n] * gsl_sf_bessel_J0(level_eps[l][n]*r);
+		sum_j1 += level_j1[l][n] * gsl_sf_bessel_J1(level_eps[l][n]*r);
 	}
 
-//	return ( LUT_vertical[eps_index++] * gsl_sf_bessel_J0(e*local_r) ) ;
+	*int_j0 = sum_j0;
+	*int_j1 = sum_j1;
 }
 
-double first_order_bessel_integral(double e, void *params)
-{	
-	//cast and dereference
-	local_r = *((double *) params);	
-	sin_h = sinh(2.0*e*H);
-	cos_h = cosh(2.0*e*H);
+/*! slot of key in the memo table m, empty slots hold -1 */
+static long memo_slot(memo_table *m, long key)
+{
+	long slot = (long) ( ((unsigned long) key * 2654435761UL) & (unsigned long) (m->size - 1) );
 
-	/* constants from Pinel et.al. (2007)*/	
-	A = e*e*H*H - nu*(cos_h-1.0) - ( (2.0 * (1.0-nu*nu)) / E ) * g*rho_f*(nu*(sin_h/e)+H); 
-	D = -1.0*e*e*e*H*H + 0.5*e*(cos_h-1.0) + ( (1.0-nu*nu)/E )*g*rho_f*(sin_h+2.0*e*H); 
+	while(m->key[slot] != -1 && m->key[slot] != key){
+		slot = (slot + 1) & (m->size - 1);
+	}
+	return slot;
+}
 
-	if(D!=0.0){
-		return  (1.0-nu*nu)*(2.0*e*A/D + nu*4.0) * gsl_sf_bessel_J1(e*local_r);
+/*! (re)allocates the memo table m with 'size' slots and re-inserts what is known */
+static void memo_resize(memo_table *m, long size)
+{
+	long *old_key = m->key;
+	double *old_j0 = m->j0, *old_j1 = m->j1;
+	long old_size = m->size, k, slot;
+
+	m->key  = (long*)   malloc(sizeof(long)   * size);
+	m->j0   = (double*) malloc(sizeof(double) * size);
+	m->j1   = (double*) malloc(sizeof(double) * size);
+	m->size = size;
+
+	if(m->key == NULL || m->j0 == NULL || m->j1 == NULL){
+		crusde_bad_alloc();
 	}
-	else{
-		return 0.0;
+
+	for(k = 0; k < size; ++k){
+		m->key[k] = -1;
 	}
-	
-//	return ( LUT_horizontal[eps_index++] *  gsl_sf_bessel_J1(e*local_r) ) ;
-}	
 
+	for(k = 0; k < old_size; ++k){
+		if(old_key[k] != -1){
+			slot = memo_slot(m, old_key[k]);
+			m->key[slot] = old_key[k];
+			m->j0[slot]  = old_j0[k];
+			m->j1[slot]  = old_j1[k];
+		}
+	}
 
+	free(old_key);
+	free(old_j0);
+	free(old_j1);
+}
 
-double f (double x, void * params) {
-       double alpha = *(double *) params;
-       double f = log(alpha*x) / sqrt(x);
-       return f;
+/*! frees the slots of the memo table m */
+static void memo_free(memo_table *m)
+{
+	free(m->key);
+	free(m->j0);
+	free(m->j1);
+	m->key  = NULL;
+	m->j0   = m->j1 = NULL;
+	m->size = m->count = 0;
+}
+
+/*! Green's function at (x,y) in the given quadrant, the Hankel transforms are kept in m */
+static int value_at(memo_table *m, int tabulate, double** result, int x, int y, int quadrant)
+{
+	double xx, yy, r, theta;
+	short sin_sign, cos_sign;
+	long key, slot;
+
+	(*result)[x_pos] = 0.0;
+	(*result)[y_pos] = 0.0;
+	(*result)[z_pos] = 0.0;
+
+	/*well, work then ... */
+
+	/* -expand index to a coordinate: x*crusde_get_gridsize() */
+	xx = x*crusde_get_gridsize();
+	yy = y*crusde_get_gridsize();
+		
+	/* -convert carthesian to cylindrical coordinates: r = srqt(x^2+y^2)*/
+	r = sqrt(xx*xx + yy*yy);
+       
+	if(r>0){
+	/*horizontal displacement*/
+		sin_sign = 1;
+		cos_sign = 1;
+		
+		/* get the angle of the cyllindrical coordinate */
+		if(xx == 0){	theta=PI/2;		}
+		else{		theta = atan(fabs(yy)/fabs(xx));	}
+		
+		/* get the direction of the direction cosine */
+		if(quadrant==2){	
+			sin_sign = -1;
+		}
+		else if(quadrant==3){	
+			sin_sign = -1;
+			cos_sign = -1;
+		}
+		else if(quadrant==4){	
+			cos_sign = -1;
+		}
+			
+	/*hankel transforms, once per distance*/
+		key  = (long) x*x + (long) y*y;
+		slot = memo_slot(m, key);
+
+		if(m->key[slot] == -1){
+			hankel_transforms(r, &m->j0[slot], &m->j1[slot], tabulate);
+			m->key[slot] = key;
+
+			if(2 * ++m->count > m->size){
+				memo_resize(m, 2 * m->size);
+				slot = memo_slot(m, key);
+			}
+		}
+
+	/*vertical displacement*/
+		(*result)[z_pos] = U_vert_const * m->j0[slot];
+	/*horizontal displacement*/
+		(*result)[x_pos] = cos_sign * cos(theta) * U_hori_const * m->j1[slot];
+		(*result)[y_pos] = sin_sign * sin(theta) * U_hori_const * m->j1[slot];
+	}	
+
+	return NOERROR;	
 }
 
 /*external functions*/	
@@ -231,6 +381,7 @@ extern const char* get_name() 	 { return "thick plate (pinel)"; }
 extern const char* get_version() { return "0.1"; }
 extern const char* get_authors() { return "ronni grapenthin"; }
 extern PluginCategory get_category() { return GREEN_PLUGIN; }
+extern GreenSymmetry get_symmetry()  { return AXIAL_SYMMETRY; }
 extern const char* get_description() { 
 	return ("The Earth is modeled as being made of an elastic layer of arbitrary thickness <i>H</i> lying \
 	over an inviscid fluid of density <i>&rho;<sub>f</sub></i>. The fully relaxed response of the Earth to \
@@ -318,40 +469,17 @@ extern void init()
 	U_vert_const 		= g/PI * ( (1.0 - nu*nu) / E );
 	U_hori_const 		= -1.0 * g / (2*PI * E * (1-2*nu) );
 
-	/*allocate gsl integration workspace*/   
-	w = gsl_integration_workspace_alloc (SIZE_W);
-	
-	j0_integral.function = &zeroth_order_bessel_integral;
-	j0_integral.params = &r;
-	
-	j1_integral.function = &first_order_bessel_integral;
-	j1_integral.params = &r;
-
-/*	init_v_LUT.function = &init_vertical_LUT;
-	init_v_LUT.params = &r;
-		
-	init_h_LUT.function = &init_horizontal_LUT;
-	init_h_LUT.params = &r;
-*/   
-    /* make integration more efficient ... create a lookup map for constant parts*/
-    /*---------------------------------------------------------------------------*/
-//	double res, error;
-    	
 	/*set upper and lower integration bound */
 	lower_integral_bound = 0;
 	upper_integral_bound = 0.003;
-	
-	/*allocate memory for lookup-tables*/
-//	LUT_vertical 	= (double*) malloc (sizeof(double) * SIZE_W);
-//	LUT_horizontal 	= (double*) malloc (sizeof(double) * SIZE_W);
-	
-	/*now the lookup-tables can be initialized */
-//	eps_index = 0;	//eps_index must be resetted before each integration because it is incremenet inside the integral functions*/
-//	gsl_integration_qag (&init_v_LUT, lower_integral_bound, upper_integral_bound, 0, 5e-7, SIZE_W, GSL_INTEG_GAUSS61, w, &res, &error);
-//crusde_info("%s: vertical init done ... ", get_name());	
-//	eps_index = 0;	//eps_index must be resetted before each integration because it is incremenet inside the integral functions*/
-//	gsl_integration_qag (&init_h_LUT, lower_integral_bound, upper_integral_bound, 0, 5e-7, SIZE_W, GSL_INTEG_GAUSS61, w, &res, &error);
-//crusde_info("%s: horizontal init done ... ", get_name());	
+
+	/* the kernel varies on a scale of 1/H, level 0 panels are at most that wide */
+	gauss_legendre(GL_ORDER, gl_node, gl_weight);
+	base_panels = (int) ceil( (upper_integral_bound - lower_integral_bound) * H );
+	if(base_panels < 1){ base_panels = 1; }
+
+	memo_free(&memo);
+	memo_resize(&memo, 1024);
 
 	/*good night and good luck ... */	   
 }
@@ -360,16 +488,20 @@ extern void init()
 extern void run(){}
 
 //! Clean-up before this plug-in gets unloaded. 
-/*! Free the integration workspace!
+/*! Free the tabulated integrands and the memo!
  */
 extern void clear()
 {
-//	free(LUT_vertical);
-//	free(LUT_horizontal);
-	if(w != NULL){
-	 	gsl_integration_workspace_free (w);
-		w = NULL;
+	int l;
+
+	for(l = 0; l < MAX_LEVEL; ++l){
+		free(level_eps[l]);
+		free(level_j0[l]);
+		free(level_j1[l]);
+		level_eps[l] = level_j0[l] = level_j1[l] = NULL;
 	}
+
+	memo_free(&memo);
 }
 
 //! Returns the Green's Function value at Point(x,y)
@@ -382,56 +514,53 @@ extern void clear()
  */
 extern int get_value_at(double** result, int x, int y)
 {
-    double error;	/* numerical error in integration*/
+	return value_at(&memo, 1, result, x, y, crusde_get_quadrant());
+}
 
-	(*result)[x_pos] = 0.0;
-	(*result)[y_pos] = 0.0;
-	(*result)[z_pos] = 0.0;
+//! Workspace of one thread for get_value_at_r()
+/*! Tabulates the integrands for all radii of the operator space, such that get_value_at_r() 
+ *  finds them. Not reentrant, the core calls it before the threads start.
+ */
+extern void* new_workspace()
+{
+	memo_table *m = (memo_table*) calloc(1, sizeof(memo_table));
+	int nx, ny, l, level;
 
-	/*well, work then ... */
+	if(m == NULL){
+		crusde_bad_alloc();
+	}
+	memo_resize(m, 1024);
 
-	/* -expand index to a coordinate: x*crusde_get_gridsize() */
-	xx = x*crusde_get_gridsize();
-	yy = y*crusde_get_gridsize();
-		
-	/* -convert carthesian to cylindrical coordinates: r = srqt(x^2+y^2)*/
-	r = sqrt(xx*xx + yy*yy);
-       
-	if(r>0){
-	/*horizontal displacement*/
-		quadrant = crusde_get_quadrant();
-		sin_sign = 1;
-		cos_sign = 1;
-		
-		/* get the angle of the cyllindrical coordinate */
-		if(xx == 0){	theta=PI/2;		}
-		else{		theta = atan(fabs(yy)/fabs(xx));	}
-		
-		/* get the direction of the direction cosine */
-		if(quadrant==2){	
-			sin_sign = -1;
-		}
-		else if(quadrant==3){	
-			sin_sign = -1;
-			cos_sign = -1;
-		}
-		else if(quadrant==4){	
-			cos_sign = -1;
+	crusde_get_operator_space(&nx, &ny);
+	level = level_at( sqrt( (double) (nx/2+1)*(nx/2+1) + (double) (ny/2+1)*(ny/2+1) ) * crusde_get_gridsize() );
+
+	for(l = 0; l <= level; ++l){
+		if(level_eps[l] == NULL){
+			init_level(l);
 		}
-			
-	/*hankel transforms*/
-		//eps_index = 0;
-		gsl_integration_qag (&j0_integral, lower_integral_bound, upper_integral_bound, 0, 5e-7, SIZE_W, GSL_INTEG_GAUSS61, w, &result_j0, &error);
-		//eps_index = 0;
-		gsl_integration_qag (&j1_integral, lower_integral_bound, upper_integral_bound, 0, 5e-7, SIZE_W, GSL_INTEG_GAUSS61, w, &result_j1, &error);
+	}
 
-	/*vertical displacement*/
-		(*result)[z_pos] = U_vert_const *  result_j0 ;
-	/*horizontal displacement*/
-		(*result)[x_pos] = cos_sign * cos(theta) * U_hori_const * result_j1;
-		(*result)[y_pos] = sin_sign * sin(theta) * U_hori_const * result_j1;
-	}	
+	return m;
+}
 
-	return NOERROR;	
+//! Frees a workspace of new_workspace()
+extern void free_workspace(void *workspace)
+{
+	memo_free( (memo_table*) workspace );
+	free(workspace);
 }
 
+//! Returns the Green's Function value at Point(x,y) in the given quadrant, reentrant
+/*!
+ 
+ * @param workspace The workspace of the calling thread, see new_workspace().
+ * @param x The x-Coordinate of the requested value.
+ * @param y The y-Coordinate of the requested value.
+ * @param quadrant The quadrant (1-4) the point lies in, gives the direction of the horizontal displacement.
+ * 
+ * @return error code
+ */
+extern int get_value_at_r(void *workspace, double** result, int x, int y, int quadrant)
+{
+	return value_at( (memo_table*) workspace, 0, result, x, y, quadrant );
+}
@@ -48,8 +48,8 @@
  * where c\epsilon\f$ is the variable of integration. If \f$H \to \infty\f$, then \f$\frac{A}{D} \to -\frac{2\nu}{\epsilon}\f$ and 
  * \f$\frac{A}{D} \to 1\f$ which gives the solution of the elastic half-space.
  *
- * The Hankel transform integral is calculated in the bounds \f$\[0 .. 0.003\]\f$ using gsl_integration_qag of the 
- * GNU Scientific Library (http://www.gnu.org/software/gsl/).
+ * The Hankel transform integral is calculated in the bounds \f$\[0 .. 0.003\]\f$ by the plug-in 'thick plate (pinel)',
+ * which tabulates the integrands once and keeps the transforms per distance (see pinel_hs_thickplate.c).
 */
 /*@}*/
 
@@ -72,6 +72,7 @@ extern const char* get_name() 	 { return "inverse thick plate (pinel)"; }
 extern const char* get_version() { return "0.1"; }
 extern const char* get_authors() { return "ronni grapenthin"; }
 extern PluginCategory get_category() { return GREEN_PLUGIN; }
+extern GreenSymmetry get_symmetry()  { return AXIAL_SYMMETRY; }
 extern const char* get_description() { 
 	return ("The negative thickplate response."); }
 
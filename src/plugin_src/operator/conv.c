@@ -18,6 +18,7 @@
 /*@}*/
 
 #include "crusde_api.h"
+#include "fft_tools.h"
 #include <math.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -155,8 +156,38 @@ extern void clear()
 /*!empty*/
 extern void run()
 {   
+    int quadrant, mirror;
+    double sign[5][3], *first = NULL;
+
     //Get Green's function and load for a suffcient region
     crusde_info("(%s) Calculating Green's function and load", get_name());
+
+    //if the Green's function declares a symmetry, evaluate the first quadrant only and mirror it
+    if (crusde_model_time() == 0)
+    {
+        mirror = 1;
+        quadrant = 0;
+        while(++quadrant <= 4){
+            mirror = mirror && fft_mirror_signs(quadrant, sign[quadrant]);
+        }
+
+        if(mirror){
+            first = (double*) malloc(sizeof(double) * (size_x/2+1)*(size_y/2+1) * displacement_dimensions);
+            if(first == NULL){ crusde_bad_alloc(); }
+
+            crusde_set_quadrant(1);
+            for(x=0; x<size_x/2+1; ++x){
+            for(y=0; y<size_y/2+1; ++y){
+                crusde_get_green_at(&green_back, x, y);
+                n=-1;
+                while(++n<displacement_dimensions){
+                    first[(x+(size_x/2+1)*y)*displacement_dimensions + n] = green_back[n];
+                }
+            }
+            }
+        }
+    }
+
     for(x=-size_x/2; x<size_x/2+1; ++x){
     for(y=-size_y/2; y<size_y/2+1; ++y){
 	 //GF is time invariant!
@@ -164,17 +195,26 @@ extern void run()
         {	
 	        if( (x >= 0) && (y >= 0) ){
 			    /*set quadrant we're in, in case of cylindrical:carthesian conversion in green's function*/
-			    crusde_set_quadrant(1);
+			    quadrant = 1;
 	        }
 	        else{
-                if( (x >= 0 ) && (y < 0)  ){ crusde_set_quadrant(2);}
+                if( (x >= 0 ) && (y < 0)  ){ quadrant = 2;}
                 else
-                if( (x < 0 )  && (y < 0)  ){ crusde_set_quadrant(3);}
+                if( (x < 0 )  && (y < 0)  ){ quadrant = 3;}
                 else
-                if( (x < 0 )  && (y >= 0) ){ crusde_set_quadrant(4);}
+                if( (x < 0 )  && (y >= 0) ){ quadrant = 4;}
             }
 
-            crusde_get_green_at(&green_back, x, y);
+            if(first != NULL){
+                n=-1;
+                while(++n<displacement_dimensions){
+                    green_back[n] = sign[quadrant][n] * first[(abs(x)+(size_x/2+1)*abs(y))*displacement_dimensions + n];
+                }
+            }
+            else{
+                crusde_set_quadrant(quadrant);
+                crusde_get_green_at(&green_back, x, y);
+            }
             /*copy results to greens function*/
             n=-1;
             while(++n<displacement_dimensions){
@@ -187,6 +227,8 @@ extern void run()
     }
     }
 
+    free(first);
+
     for(x=0; x<size_x; ++x){
     for(y=0; y<size_y; ++y){
        load[x+size_x*(y)] = crusde_get_load_at(x, y);
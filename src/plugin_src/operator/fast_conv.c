@@ -20,32 +20,114 @@
 
 #include <complex.h>
 #include <fftw3.h>
+#include <omp.h>
 #include "crusde_api.h"
+#include "fft_tools.h"
 #include <stdarg.h>
 #include <stdio.h>
 #include <time.h>
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 
 #define RESET(x,y) (x = y = -1)
 #define POSITION(m,n) (n+(N_Y)*m)
+/* a load is taken as a multiple of the previous one if all values agree to this relative tolerance, */
+/* well below the round off of the DFTs */
+#define SCALE_TOLERANCE 1.0e-12
+/* spectral values per thread and pass when load spectra are summed, see convolve_transformed() */
+#define SUM_BLOCK 1024
+
+/** 
+ * Spectrum of a Green's function plugin, or of the weighted sum of plugins of one job. The 
+ * Green's function does not change within a job, so its DFT is computed once, pre-scaled by 
+ * 1/N and reused by every later call, i.e. for all timesteps, all load components, repeated 
+ * calls from 'fast 3d convolution' and other jobs using the same plugin.
+ */
+typedef struct s_green_spectrum
+{   
+	char *plugin;				/*name of the Green's function plugin*/
+	char *job;				/*job of a weighted sum of plugins, empty for the spectrum of a single plugin*/
+	int gridsize;				/*side length of a grid cell*/
+	int size_x, size_y;			/*region of interest*/
+	int n_x, n_y;				/*operator space*/
+	fftw_complex  *block;			/*half spectra of all displacement dimensions, scaled by 1/N, NULL if unused*/
+	fftwf_complex *block_f;			/*the same in single precision, NULL if unused*/
+	double *quarter;			/*green_transform = 'r2r': real spectra of the quadrant kx, ky >= 0, scaled by 1/N, NULL if unused*/
+	float  *quarter_f;			/*the same in single precision, NULL if unused*/
+	struct s_green_spectrum *next;		/*next element in the cache*/
+} green_spectrum;
 
 /*variables*/
-double       *load_in,  *green_in,  *conv_out, *green_back;
-fftw_complex *load_out, *green_out, *conv_in;
+/* load_in/load_out and conv_in/conv_out share memory, the transforms are done in-place */
+/* conv_in holds one half spectrum per displacement dimension, they are transformed in one batch */
+double       *load_in,  *conv_out, *green_back;
+fftw_complex *load_out, *conv_in;
 fftw_plan     load_plan, green_plan, conv_plan;
 
-double      **model_buffer, **result;
+/* the same in single precision */
+float         *load_in_f,  *conv_out_f;
+fftwf_complex *load_out_f, *conv_in_f;
+fftwf_plan     load_plan_f, green_plan_f, conv_plan_f;
 
-/* *_X: number of rows, *_Y: number of columns*/
+double      **result;
+double      **reference;	/*double precision results in 'compare' mode*/
+
+/* the load that was last convolved and the convolution result, a load that is equal or a */
+/* multiple of it is not convolved again, see run() */
+double       *load_now, *base_load;
+double      **base_result;
+green_spectrum *base_green = NULL;	/*spectrum the base result was computed with, NULL: no base result*/
+
+green_spectrum *spectrum_cache = NULL;
+
+/* N_X: length of a row (x, fast index), N_Y: number of rows (y)*/
 int N, N_X, N_Y;
+/* N_XC: complex values per row of the half spectrum, N_XR: padded length of a real row for in-place DFT, N_C: half spectrum size*/
+int N_XC, N_XR, N_C;
 int size_x, size_y;
 int x=-1, y=-1, i=0, n=-1;
-unsigned long int t=0;
 int dimensions=1;
 int displacement_dimensions=1;
 
+char **p_fft_size;		/*choice of DFT size: 'smooth' (default) or 'auto' (benchmark candidates)*/
+char **p_fft_planner;		/*FFTW planner rigor: 'estimate' (default), 'measure' or 'patient'*/
+unsigned planner_flags = FFTW_ESTIMATE;
+double *p_threads;		/*number of threads, <= 0: all available cores*/
+int threads = 1;
+char **p_precision;		/*spectral path: 'double' (default), 'single' or 'compare'*/
+boolean use_double = true;	/*the double precision path is set up*/
+boolean use_single = false;	/*the single precision path is set up, its results are handed out*/
+
+double *p_kernel_radius;	/*radius of the Green's function support in m, 0: not truncated*/
+double *p_kernel_tolerance;	/*relative tolerance the kernel radius is chosen from if kernel_radius is 0, 0: off*/
+int kernel_radius = -1;		/*radius in grid cells, -1: not truncated*/
+
+char **p_green_spectrum;	/*'auto' (default): 'analytic' if it needs no larger DFTs than 'sampled', 'analytic': closed form spectrum of the Green's function if it has one, 'sampled': DFT of samples*/
+boolean use_analytic = false;	/*the Green's function spectra come from crusde_get_green_spectrum_at()*/
+int spectrum_radius = -1;	/*radius in grid cells the closed form spectrum is truncated to*/
+
+char **p_green_transform;	/*'dft' (default): complex half spectra of the Green's function, 'r2r': real even/odd transforms*/
+boolean use_r2r = false;	/*the Green's function spectra are stored as quarters, see transform_quarter()*/
+/* N_QX, N_QY: quadrant kx, ky >= 0 of the spectrum, N_Q: values per displacement dimension, keeps the alignment */
+int N_QX, N_QY, N_Q;
+fftw_plan  green_r2r[3];	/*REDFT00 along an axis the component is even in, RODFT00 along an axis it is odd in*/
+fftwf_plan green_r2r_f[3];
+
+/* 'fast 3d convolution' convolves its loads in batches, one load per thread, with buffers of each */
+/* thread and plans for one thread, which are executed on the buffers (see convolve_loads()) */
+double       **batch_load_in,  **batch_conv_out;
+fftw_complex **batch_load_out, **batch_conv_in;
+fftw_plan      batch_load_plan, batch_conv_plan;
+
+/* spectra of the loads of 'fast 3d convolution', it sums them in the spectral domain (see transform_loads()) */
+fftw_complex **load_spectra = NULL;
+int spectra_loads = 0;
+
 boolean is_initialized = false;
+boolean is_planned = false;	/*DFT buffers and plans are set up, see setup_transforms()*/
+boolean is_batched = false;	/*buffers and plans for batches of loads are set up, see setup_batch()*/
 
 /* plugin interface */
 extern void register_output_fields();
@@ -55,6 +137,11 @@ extern void init();
 extern void clear();
 extern void run();
 
+/* batch interface for 'fast 3d convolution', see crusde_request_kernel_function() */
+extern boolean convolve_loads(int loads, double ***out);
+extern void*   transform_loads(int loads);
+extern void    convolve_transformed(void *green, const double *weight, double **out);
+
 extern const char* get_name() 	 { return "fast 2d convolution"; }
 extern const char* get_version() { return "0.1"; }
 extern const char* get_authors() { return "ronni grapenthin"; }
@@ -81,187 +168,719 @@ extern void register_output_fields(){}
  *  identification of parameters in the command line string (i.e. './green -KfirstRegistered/secondRegistered/...').
  *  In case an XML is used to configure the experiment, the reference to this parameter will be identified by 
  *  the string passed as second argument to register_kernel_param().
- *
+ * 
  *  This function registers the references in the following order:
- *
+ *	-# fft_size	(optional, 'smooth' or 'auto', default: 'smooth')
+ *	-# fft_planner	(optional, 'estimate', 'measure' or 'patient', default: 'estimate')
+ *	-# threads	(optional, default: 0, i.e. number of available cores)
+ *	-# precision	(optional, 'double', 'single' or 'compare', default: 'double')
+ *	-# kernel_radius	(optional, support of the Green's function in m, default: 0, i.e. not truncated)
+ *	-# kernel_tolerance	(optional, relative tolerance for an automatic kernel_radius, default: 0, i.e. off)
+ *	-# green_spectrum	(optional, 'auto', 'analytic' or 'sampled', default: 'auto')
+ *	-# green_transform	(optional, 'dft' or 'r2r', default: 'dft')
+ * 
  *  Thus, the command line parameter string is: <tt>-K</tt>
- *
+ * 
  *  @see register_kernel_param()
  *  @see register_parameter() (temp_plugin.c.tmp)
  */
 extern void register_parameter(){
    /* tell main program about parameters we claim from input */
+   p_fft_size = crusde_register_optional_param_string("fft_size", get_category(), "smooth");
+   p_fft_planner = crusde_register_optional_param_string("fft_planner", get_category(), "estimate");
+   p_threads     = crusde_register_optional_param_double("threads", get_category(), 0.0);
+   p_precision   = crusde_register_optional_param_string("precision", get_category(), "double");
+   p_kernel_radius    = crusde_register_optional_param_double("kernel_radius", get_category(), 0.0);
+   p_kernel_tolerance = crusde_register_optional_param_double("kernel_tolerance", get_category(), 0.0);
+   p_green_spectrum   = crusde_register_optional_param_string("green_spectrum", get_category(), "auto");
+   p_green_transform  = crusde_register_optional_param_string("green_transform", get_category(), "dft");
 }
 
-//! Initialization of the convolution. Allocation of memory for inputs and outputs
-/**
+
+/*! largest distance between two points of the region in grid cells*/
+static int max_offset()
+{
+   return (int) ceil( sqrt( (double) (size_x-1)*(size_x-1) + (double) (size_y-1)*(size_y-1) ) );
+}
+
+/*! offset of the first transformed value in the quadrant of displacement dimension d, which is 0 on the axes it is odd in*/
+static int quarter_offset(int d)
+{
+   return (d == crusde_get_x_index() ? 1 : 0) + (d == crusde_get_y_index() ? N_QX : 0);
+}
+
+//! Sets up DFT sizes, buffers and FFTW plans for the current kernel radius
+/** 
  * The field sizes are adjusted according to the needs to avoid wrap around
- * effects in the spectal domain and allow for effective use of DFT (lenght and 
- * width are a power of 2). Memory is allocated using fftw_malloc for DFT inputs
- * and outputs (load_in, load_out, green_in, green_out, conv_in, conv_out).
- * Three FFTW plans are created for DFT transform of Green and load arrays and
- * IDFT of the convolution result back to original domain.
+ * effects in the spectal domain and allow for effective use of DFT. Each axis is 
+ * padded independently to at least 2*size-1, rounded up to the next length that 
+ * factors into 2, 3, 5 and 7 (fft_size = 'smooth'). With fft_size = 'auto' a few 
+ * candidate sizes are benchmarked and the fastest is used. A kernel truncated to 
+ * kernel_radius needs only size+kernel_radius values.
+ *
+ * A closed form spectrum (see get_green_spectrum()) is that of the Green's function 
+ * truncated to a disk, of radius kernel_radius or, if not truncated, the largest offset 
+ * within the region. Its corners reach beyond size-1 along the axes, so each axis is 
+ * padded to size+radius. With green_spectrum = 'auto' it is only used if that is no more 
+ * than the padding of the sampled Green's function, i.e. if the kernel radius is at most 
+ * size-1 along both axes: the larger DFTs of every load and every convolution would cost 
+ * more than the one DFT per Green's function it saves.
+ *
+ * Memory is allocated using fftw_malloc for DFT inputs and outputs. Since the input is 
+ * real, only the non-redundant half of the spectrum (N_Y*(N_X/2+1) complex values) is 
+ * stored. All transforms are done in-place, load_in and conv_out are the real views of 
+ * load_out and conv_in, with rows padded to 2*(N_X/2+1) values. The Green's function 
+ * components and the convolution results of all displacement dimensions are stored back 
+ * to back and transformed as one batch. Three FFTW plans are created for DFT transform 
+ * of Green and load arrays and IDFT of the convolution result back to original domain. 
+ * The planner rigor is set by fft_planner; wisdom is read from and merged into the store 
+ * in $CRUSDE_HOME/cache (see fft_tools.c).
+ *
+ * With green_transform = 'r2r' both axes are padded to an even length of at least 4, and a 
+ * real-to-real plan is created per displacement dimension for the quadrant of the Green's 
+ * function, see transform_quarter().
  */
-extern void init(){
+static void setup_transforms()
+{
+   int shape[2], real_shape[2], complex_shape[2], quarter_shape[2], r2r_shape[2];
+   fftw_r2r_kind kind[2];
+   int reach_x, reach_y;
+
 /*------------------------------*/
 /*determine dimensions of DFT	*/
 /*------------------------------*/
-   size_x = crusde_get_size_x(); // LONGITUDE
-   size_y = crusde_get_size_y(); // LATITUDE
+   /* offsets the kernel covers, at most the largest offset between two points of the region */
+   reach_x = (kernel_radius >= 0 && kernel_radius < size_x-1 ? kernel_radius : size_x-1);
+   reach_y = (kernel_radius >= 0 && kernel_radius < size_y-1 ? kernel_radius : size_y-1);
 
-   dimensions = crusde_get_dimensions();
-   displacement_dimensions = crusde_get_displacement_dimensions();
-   /* find a size long enough and a power of two to allocate memory for DFT*/    
-   /*get minimum values for DFT size in x and y direction*/
-   /*we take the bigger*/
-   if(size_x > size_y){
-	N_X = 2*size_x;
- 	N_Y = N_X;
-   }else{
-   	N_Y = 2*size_y;
-	N_X = N_Y;
+   /* the closed form spectrum of a Green's function that is not truncated within the region needs larger DFTs */
+   if(use_analytic && strcmp(*p_green_spectrum, "auto") == 0 && 
+      (kernel_radius < 0 || kernel_radius > size_x-1 || kernel_radius > size_y-1)){
+	use_analytic = false;
    }
 
-   /* find power of 2 that is closest to N_* and greater than or equal to N_* */ 
-   while(N_X>pow(2,i)){++i;}
-   N_X = pow(2,i);
+   if(use_analytic){
+	spectrum_radius = (kernel_radius >= 0 ? kernel_radius : max_offset());
+	reach_x = spectrum_radius;
+	reach_y = spectrum_radius;
+   }
+
+   /* a linear convolution of a field of length 'size' with a kernel covering offsets -reach ... reach */
+   /* needs at least size+reach values, i.e. 2*size-1 for a kernel that is not truncated */
+   if(strcmp(*p_fft_size, "auto") == 0){
+	fft_tune_size_2d(size_x+reach_x, size_y+reach_y, planner_flags, &N_X, &N_Y);
+   }
+   else{
+	N_X = fft_smooth_size(size_x+reach_x);
+	N_Y = fft_smooth_size(size_y+reach_y);
+   }
 
-   N_Y = N_X;
+   /* the even and odd extensions of a quadrant have even length, the odd one needs an interior */
+   while(use_r2r && (N_X % 2 != 0 || N_X < 4)){
+	N_X = fft_smooth_size(N_X+1);
+   }
+   while(use_r2r && (N_Y % 2 != 0 || N_Y < 4)){
+	N_Y = fft_smooth_size(N_Y+1);
+   }
 
    /* N = total number of DFT elements */
    N = N_X*N_Y;
 
+   /* real input has a hermitian spectrum, only half of it is needed */
+   N_XC = N_X/2 + 1;
+   N_XR = 2*N_XC;
+   N_C  = N_Y*N_XC;
+
+   /* logical size and the padded in-place layouts of real and complex data for the batched plans */
+   shape[0] = N_Y;	shape[1] = N_X;
+   real_shape[0] = N_Y;	real_shape[1] = N_XR;
+   complex_shape[0] = N_Y;	complex_shape[1] = N_XC;
+
+   /* quadrant of the spectrum, rounded up to keep each block as aligned as the first one */
+   N_QX = N_X/2 + 1;
+   N_QY = N_Y/2 + 1;
+   N_Q  = (N_QX*N_QY + 15) / 16 * 16;
+
+   crusde_info("(%s) DFT size: %d x %d, %s precision", get_name(), N_X, N_Y, *p_precision);
+   if(kernel_radius >= 0){
+	crusde_info("(%s) Green's function truncated at %d grid cells", get_name(), kernel_radius);
+   }
+   if(use_analytic){
+	crusde_info("(%s) closed form spectrum of the Green's function, radius %d grid cells", get_name(), spectrum_radius);
+   }
+   if(use_r2r){
+	crusde_info("(%s) real transforms of the Green's function, %d x %d values per dimension", get_name(), N_QX, N_QY);
+   }
    crusde_set_operator_space(N_X, N_Y);
 
+
+   if(use_double){
+	load_out = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * N_C);
+	conv_in  = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * N_C * displacement_dimensions);
+
+	if (load_out == NULL || conv_in == NULL) {
+		crusde_bad_alloc();
+	}
+
+	load_in  = (double*) load_out;
+	conv_out = (double*) conv_in;
+   }
+
+   if(use_single){
+	load_out_f = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * N_C);
+	conv_in_f  = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * N_C * displacement_dimensions);
+
+	if (load_out_f == NULL || conv_in_f == NULL) {
+		crusde_bad_alloc();
+	}
+
+	load_in_f  = (float*) load_out_f;
+	conv_out_f = (float*) conv_in_f;
+   }
+
+
 /*------------------------------*/
-/*Allocation of Memory		*/
+/*Creation of Deformation Plans	*/
 /*------------------------------*/
-   load_in  = (double*) fftw_malloc(sizeof(double) * N);
-   load_out = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * N); // (floor(N/2)+1));
+   /* fftw_plan_dft_r2c_1d is always FFTW_FORWARD, 		*/
+   /* fftw_plan_dft_c2c_1d is always FFTW_BACKWARD 		*/ 
+   crusde_info("(%s) planning FFT ...", get_name());
+   /* row major: N_Y rows of N_X values, i.e. value (x,y) is found at x+N_XR*y */
+   /* batched transforms of all displacement dimensions, each one N_C complex values apart */
+   /* green_plan is executed on the cached spectra, see get_green_spectrum() */
+   if(use_double){
+	load_plan = fftw_plan_dft_r2c_2d(N_Y, N_X, load_in, load_out, planner_flags);
+	green_plan= fftw_plan_many_dft_r2c(2, shape, displacement_dimensions,
+	                                   conv_out, real_shape, 1, 2*N_C,
+	                                   conv_in, complex_shape, 1, N_C, planner_flags);
+	conv_plan = fftw_plan_many_dft_c2r(2, shape, displacement_dimensions,
+	                                   conv_in, complex_shape, 1, N_C,
+	                                   conv_out, real_shape, 1, 2*N_C, planner_flags);
+   }
+
+   if(use_single){
+	load_plan_f = fftwf_plan_dft_r2c_2d(N_Y, N_X, load_in_f, load_out_f, planner_flags);
+	green_plan_f= fftwf_plan_many_dft_r2c(2, shape, displacement_dimensions,
+	                                      conv_out_f, real_shape, 1, 2*N_C,
+	                                      conv_in_f, complex_shape, 1, N_C, planner_flags);
+	conv_plan_f = fftwf_plan_many_dft_c2r(2, shape, displacement_dimensions,
+	                                      conv_in_f, complex_shape, 1, N_C,
+	                                      conv_out_f, real_shape, 1, 2*N_C, planner_flags);
+   }
+
+   /* in-place on the quadrant of one displacement dimension, planned on the scratch space of conv_out */
+   /* an odd component is transformed without its zeros on the axis, from offset quarter_offset() */
+   if(use_r2r){
+	quarter_shape[0] = N_QY;	quarter_shape[1] = N_QX;
+
+	n=-1;
+	while(++n < displacement_dimensions){
+		r2r_shape[0] = (n == crusde_get_y_index() ? N_Y/2 - 1 : N_QY);
+		r2r_shape[1] = (n == crusde_get_x_index() ? N_X/2 - 1 : N_QX);
+		kind[0] = (n == crusde_get_y_index() ? FFTW_RODFT00 : FFTW_REDFT00);
+		kind[1] = (n == crusde_get_x_index() ? FFTW_RODFT00 : FFTW_REDFT00);
+
+		if(use_double){
+			green_r2r[n] = fftw_plan_many_r2r(2, r2r_shape, 1,
+			                                  conv_out + n*N_Q + quarter_offset(n), quarter_shape, 1, 0,
+			                                  conv_out + n*N_Q + quarter_offset(n), quarter_shape, 1, 0,
+			                                  kind, planner_flags);
+		}
+		if(use_single){
+			green_r2r_f[n] = fftwf_plan_many_r2r(2, r2r_shape, 1,
+			                                     conv_out_f + n*N_Q + quarter_offset(n), quarter_shape, 1, 0,
+			                                     conv_out_f + n*N_Q + quarter_offset(n), quarter_shape, 1, 0,
+			                                     kind, planner_flags);
+		}
+	}
+   }
+
+   if(planner_flags != FFTW_ESTIMATE){
+	fft_export_wisdom();
+   }
+
+   is_planned = true;
+}
+
+//! Initialization of the convolution. Allocation of memory for inputs and outputs
+/** 
+ * Reads the parameters and allocates the results. The DFT buffers and plans are set up by 
+ * setup_transforms(), right away, or, if the kernel radius is chosen from kernel_tolerance, 
+ * on the first call of run(): the Green's function is not initialized before the operator.
+ * 
+ * With precision = 'single' buffers and plans are set up for fftwf only, which halves the
+ * memory of the spectral path; results are converted to double when they are extracted.
+ * precision = 'compare' sets up both paths, hands out the single precision results and
+ * reports their deviation from the double precision results on every call.
+ *
+ * With green_transform = 'r2r' the Green's function spectra are computed and stored for the
+ * quadrant kx, ky >= 0 only, by real even/odd transforms (see transform_quarter()).
+ */
+extern void init(){
+   size_x = crusde_get_size_x(); // LONGITUDE
+   size_y = crusde_get_size_y(); // LATITUDE
+
+   dimensions = crusde_get_dimensions();
+   displacement_dimensions = crusde_get_displacement_dimensions();
+
+   if(strcmp(*p_precision, "double") == 0){
+	use_double = true;
+	use_single = false;
+   }
+   else if(strcmp(*p_precision, "single") == 0){
+	use_double = false;
+	use_single = true;
+   }
+   else if(strcmp(*p_precision, "compare") == 0){
+	use_double = true;
+	use_single = true;
+   }
+   else{
+	crusde_error("(%s) unknown value for parameter precision: '%s' (use 'double', 'single' or 'compare')", get_name(), *p_precision);
+   }
+
+   /* threaded FFTW plans, the element-wise loops in run() use the same number of threads */
+   threads = fft_init_threads(*p_threads);
+
+   /* plans of higher rigor profit from, and add to the wisdom of earlier runs */
+   planner_flags = fft_planner_flags(*p_fft_planner);
+   fft_import_wisdom();
+
+   if(strcmp(*p_fft_size, "smooth") != 0 && strcmp(*p_fft_size, "auto") != 0){
+	crusde_error("(%s) unknown value for parameter fft_size: '%s' (use 'smooth' or 'auto')", get_name(), *p_fft_size);
+   }
 
-   green_in  = (double*) fftw_malloc(sizeof(double) * N);
-   green_out = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * N); //(floor(N/2)+1));
-   
-   conv_in  = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * N); // (floor(N/2)+1));
-   conv_out = (double*) fftw_malloc(sizeof(double) * N);
+   /* the spectrum in closed form is used if the Green's functions of all jobs have one, see setup_transforms() for 'auto' */
+   if(strcmp(*p_green_spectrum, "analytic") == 0 || strcmp(*p_green_spectrum, "auto") == 0){
+	use_analytic = crusde_green_has_spectrum();
+   }
+   else if(strcmp(*p_green_spectrum, "sampled") == 0){
+	use_analytic = false;
+   }
+   else{
+	crusde_error("(%s) unknown value for parameter green_spectrum: '%s' (use 'auto', 'analytic' or 'sampled')", get_name(), *p_green_spectrum);
+   }
+
+   if(strcmp(*p_green_transform, "dft") == 0){
+	use_r2r = false;
+   }
+   else if(strcmp(*p_green_transform, "r2r") == 0){
+	use_r2r = true;
+   }
+   else{
+	crusde_error("(%s) unknown value for parameter green_transform: '%s' (use 'dft' or 'r2r')", get_name(), *p_green_transform);
+   }
 
-   model_buffer = (double**) fftw_malloc(sizeof(double*) * dimensions);
+/*------------------------------*/
+/*Allocation of Memory		*/
+/*------------------------------*/
    result       = (double**) fftw_malloc(sizeof(double*) * dimensions);
    green_back   = (double*) fftw_malloc(sizeof(double) * displacement_dimensions);
 
-   if (load_in == NULL  || load_out == NULL  || 
-       green_in == NULL || green_out == NULL || 
-       conv_in == NULL || conv_out == NULL || 
-       model_buffer == NULL || result == NULL || green_back == NULL) {
-
+   if (result == NULL || green_back == NULL) {
        crusde_bad_alloc();
    }
 
-
    n=-1;
    while(++n < dimensions){
-	model_buffer[n] = (double*) fftw_malloc(sizeof(double) * N);
    	result[n] 	= (double*) fftw_malloc(sizeof(double) /* N);*/ * size_x * size_y);
-	   
-	if (model_buffer[n] == NULL  || result[n] == NULL){
+
+	if (result[n] == NULL){
 		crusde_bad_alloc();
 	}
 	//init
 	x = -1;
-	while(++x < N){
-		model_buffer[n][x] = 0.0;
-		if(x < size_x * size_y){
-			result[n][x] = 0.0;
+	while(++x < size_x * size_y){
+		result[n][x] = 0.0;
+	}
+   }
+
+   /* region of interest of the current and the last convolved load, last convolution result */
+   load_now    = (double*) fftw_malloc(sizeof(double) * size_x * size_y);
+   base_load   = (double*) fftw_malloc(sizeof(double) * size_x * size_y);
+   base_result = (double**) fftw_malloc(sizeof(double*) * displacement_dimensions);
+
+   if (load_now == NULL || base_load == NULL || base_result == NULL){
+	crusde_bad_alloc();
+   }
+
+   n=-1;
+   while(++n < displacement_dimensions){
+	base_result[n] = (double*) fftw_malloc(sizeof(double) * size_x * size_y);
+
+	if (base_result[n] == NULL){
+		crusde_bad_alloc();
+	}
+   }
+
+   base_green = NULL;
+
+   /* 'compare': the double precision results go here, the single precision ones to result */
+   if(use_double && use_single){
+	reference = (double**) fftw_malloc(sizeof(double*) * displacement_dimensions);
+
+	if (reference == NULL){
+		crusde_bad_alloc();
+	}
+
+	n=-1;
+	while(++n < displacement_dimensions){
+		reference[n] = (double*) fftw_malloc(sizeof(double) * size_x * size_y);
+
+		if (reference[n] == NULL){
+			crusde_bad_alloc();
 		}
 	}
    }
 
-  
-/*------------------------------*/
-/*Creation of Deformation Plans	*/
-/*------------------------------*/
-   /* fftw_plan_dft_r2c_1d is always FFTW_FORWARD, 		*/
-   /* fftw_plan_dft_c2c_1d is always FFTW_BACKWARD 		*/ 
-   crusde_info("(%s) planning FFT ...", get_name());
-   load_plan = fftw_plan_dft_r2c_2d(N_X, N_Y, load_in, load_out, FFTW_ESTIMATE);
-   green_plan= fftw_plan_dft_r2c_2d(N_X, N_Y, green_in, green_out, FFTW_ESTIMATE);
-   conv_plan = fftw_plan_dft_c2r_2d(N_X, N_Y, conv_in, conv_out, FFTW_ESTIMATE);
+
+   /* without an automatic kernel radius the DFT size is known now */
+   if(*p_kernel_tolerance <= 0.0 || *p_kernel_radius > 0.0){
+	kernel_radius = fft_kernel_radius(*p_kernel_radius, 0.0, max_offset());
+	setup_transforms();
+   }
 
    /*convolution is now initialized*/   
    is_initialized = true;
 }
 
+/*! Frees all cached Green's function spectra.*/
+static void free_spectrum_cache()
+{   
+   green_spectrum *entry;
+
+   while(spectrum_cache != NULL){
+	entry = spectrum_cache;
+	spectrum_cache = entry->next;
+
+	if(entry->block != NULL)
+		fftw_free(entry->block);
+	if(entry->block_f != NULL)
+		fftwf_free(entry->block_f);
+	if(entry->quarter != NULL)
+		fftw_free(entry->quarter);
+	if(entry->quarter_f != NULL)
+		fftwf_free(entry->quarter_f);
+
+	free(entry->plugin);
+	free(entry->job);
+	free(entry);
+   }
+}
+
 /*! Frees memory allocated during init(). FFTW plans are destroyed.*/
 extern void clear(){ 
    if(is_initialized)
    {
-	   fftw_destroy_plan(green_plan);
-	   fftw_destroy_plan(load_plan);   
-	   fftw_destroy_plan(conv_plan);
-	   
-	   fftw_free(green_in);
-	   fftw_free(green_out);
-	   fftw_free(load_in);
-	   fftw_free(load_out);
-	   fftw_free(conv_in);
-	   fftw_free(conv_out);
+	   if(is_planned && use_double){
+		   fftw_destroy_plan(green_plan);
+		   fftw_destroy_plan(load_plan);
+		   fftw_destroy_plan(conv_plan);
+
+		   fftw_free(load_out);
+		   fftw_free(conv_in);
+	   }
+
+	   if(is_planned && use_single){
+		   fftwf_destroy_plan(green_plan_f);
+		   fftwf_destroy_plan(load_plan_f);
+		   fftwf_destroy_plan(conv_plan_f);
+
+		   fftwf_free(load_out_f);
+		   fftwf_free(conv_in_f);
+	   }
+
+	   if(is_batched){
+		   fftw_destroy_plan(batch_load_plan);
+		   fftw_destroy_plan(batch_conv_plan);
+
+		   n=-1;
+		   while(++n < threads){
+			fftw_free(batch_load_out[n]);
+			fftw_free(batch_conv_in[n]);
+		   }
+		   free(batch_load_in);
+		   free(batch_load_out);
+		   free(batch_conv_in);
+		   free(batch_conv_out);
+
+		   is_batched = false;
+	   }
+
+	   if(load_spectra != NULL){
+		   n=-1;
+		   while(++n < spectra_loads){
+			fftw_free(load_spectra[n]);
+		   }
+		   free(load_spectra);
+		   load_spectra  = NULL;
+		   spectra_loads = 0;
+	   }
+
+	   if(is_planned && use_r2r){
+		   n=-1;
+		   while(++n < displacement_dimensions){
+			if(use_double) fftw_destroy_plan(green_r2r[n]);
+			if(use_single) fftwf_destroy_plan(green_r2r_f[n]);
+		   }
+	   }
+
+	   if(use_double && use_single){
+		   n=-1;
+		   while(++n < displacement_dimensions){
+			fftw_free(reference[n]);
+		   }
+		   fftw_free(reference);
+	   }
+
+	   n=-1;
+	   while(++n < displacement_dimensions){
+		fftw_free(base_result[n]);
+	   }
+	   fftw_free(base_result);
+	   fftw_free(load_now);
+	   fftw_free(base_load);
+	   base_green = NULL;
 
 	   n=-1;
 	   while(++n < dimensions){ 
-		if(model_buffer[n] != NULL)
-		   	fftw_free(model_buffer[n]); 
 		if(result[n] != NULL)
 		   	fftw_free(result[n]); 
 	   }
 
-	   fftw_free(model_buffer);   
 	   fftw_free(result);   
 	   fftw_free(green_back);   
+
+	   free_spectrum_cache();
+
+	   is_planned = false;
   }
 }
 
-//! Performs the fast convolution
+/*! value of displacement dimension d at index k of the Green's function buffers*/
+static double green_buffer_at(double **model_buffer, float **model_buffer_f, int d, int k)
+{
+   return model_buffer != NULL ? model_buffer[d][k] : (double) model_buffer_f[d][k];
+}
+
+/*! writes the values of all displacement dimensions to index k of the Green's function buffers*/
+static void green_buffer_set(double **model_buffer, float **model_buffer_f, int k, const double *value)
+{
+   int d;
+
+   for(d = 0; d < displacement_dimensions; ++d){
+	if(model_buffer != NULL)
+		model_buffer[d][k] = value[d];
+	if(model_buffer_f != NULL)
+		model_buffer_f[d][k] = (float) value[d];
+   }
+}
+
+//! Samples the Green's function on the operator space row by row with 'threads' threads
 /** 
- * Requests values for each point in the examined area from Green's function (only once when modeltime == 0) 
- * and load function (every timestep). Does the origin shifting necessary for the Green's function values.
- * The Green's function values are requested for each displacement direction the Green's function 
- * registered with the CrusDe. 
- * 
- * FFTW plan is executed for the load. Then for each Green's function displacement direction the FFTW plan 
- * is executed, a complex multiplication of the DFT results performed and then for product the FFTW plan
- * is executed (IDFT). The result of the convolution is extracted from the oversized IDFT result and 
- * cropped to the original size of the examined region.
- * 
- * CAN ONLY BE USE FOR ONE LOAD (i.e. multiple loads in one load file), to realize reuse of this 
- * operator in fast_conv_time_space - the loads want to have independent load histories!
+ * Fills the buffers like sample_green(), for Green's functions that can be evaluated by 
+ * several threads at once (see crusde_green_is_reentrant()). Each thread evaluates whole rows 
+ * with a workspace of its own, segment by segment with fft_green_row(), which lets the 
+ * Green's function compute many points per call (see crusde_get_green_row_at()); rows are 
+ * handed out dynamically since the cost per point varies. A segment ends at the kernel radius.
+ * With a symmetry, the first quadrant is evaluated and the other quadrants are mirrored from 
+ * it afterwards. An axisymmetric Green's function is evaluated for x >= y only, (y,x) is (x,y) 
+ * with the horizontal components swapped.
  */
-extern void run()
+static void sample_green_rows(double **model_buffer, float **model_buffer_f)
+{
+   /* loop variables of the parallel loops, the global ones would be shared between threads */
+   int row, col, dx, dy, q, d, lo, hi, last, mirror, axial;
+   int x_index = crusde_get_x_index();
+   int y_index = crusde_get_y_index();
+   double sign[5][3];
+   void **workspace = (void**) malloc(sizeof(void*) * threads);
+
+   if(workspace == NULL){
+	crusde_bad_alloc();
+   }
+
+   mirror = 1;
+   q = 0;
+   while(++q <= 4){
+	mirror = mirror && fft_mirror_signs(q, sign[q]);
+   }
+   axial = mirror && crusde_get_green_symmetry() == AXIAL_SYMMETRY;
+
+   /* workspaces are not created reentrantly */
+   q = -1;
+   while(++q < threads){
+	workspace[q] = crusde_new_green_workspace();
+   }
+
+   /* evaluate: points within the radius, only the first quadrant if the others are mirrored */
+   #pragma omp parallel num_threads(threads) private(col, dx, dy, lo, hi, last)
+   {
+	double zero[3] = {0.0, 0.0, 0.0};
+	double *value = (double*) malloc(sizeof(double) * (N_X/2+1) * displacement_dimensions);
+	void *ws = workspace[omp_get_thread_num()];
+
+	if(value == NULL){
+		crusde_bad_alloc();
+	}
+
+	#pragma omp for schedule(dynamic)
+	for(row = 0; row < N_Y; ++row){
+	    dy = (row <= N_Y/2 ? row : N_Y-row);
+
+	    for(col = 0; col < N_X; ++col){
+		green_buffer_set(model_buffer, model_buffer_f, col+N_XR*row, zero);
+	    }
+
+	    /* largest distance dx within the radius, columns N_X-last ... N_X-1 have dx = last ... 1 */
+	    hi = N_X/2;
+	    while(hi >= 0 && kernel_radius >= 0 && hi*hi + dy*dy > kernel_radius*kernel_radius){
+		--hi;
+	    }
+	    last = (hi < N_X-1-N_X/2 ? hi : N_X-1-N_X/2);
+
+	    if(row <= N_Y/2){
+		lo = (axial && row <= N_X/2 ? row : 0);
+		if(lo <= hi){
+			fft_green_row(ws, value, displacement_dimensions, lo, row, hi-lo+1, 1);
+			for(col = lo; col <= hi; ++col){
+				green_buffer_set(model_buffer, model_buffer_f, col+N_XR*row, &value[(col-lo)*displacement_dimensions]);
+			}
+		}
+		if(!mirror && last > 0){
+			/* do origin shift (see paper)*/
+			fft_green_row(ws, value, displacement_dimensions, 1, row, last, 4);
+			for(dx = 1; dx <= last; ++dx){
+				green_buffer_set(model_buffer, model_buffer_f, N_X-dx+N_XR*row, &value[(dx-1)*displacement_dimensions]);
+			}
+		}
+	    }
+	    else if(!mirror){
+		if(hi >= 0){
+			fft_green_row(ws, value, displacement_dimensions, 0, dy, hi+1, 2);
+			for(col = 0; col <= hi; ++col){
+				green_buffer_set(model_buffer, model_buffer_f, col+N_XR*row, &value[col*displacement_dimensions]);
+			}
+		}
+		if(last > 0){
+			fft_green_row(ws, value, displacement_dimensions, 1, dy, last, 3);
+			for(dx = 1; dx <= last; ++dx){
+				green_buffer_set(model_buffer, model_buffer_f, N_X-dx+N_XR*row, &value[(dx-1)*displacement_dimensions]);
+			}
+		}
+	    }
+	}
+
+	free(value);
+   }
+
+   /* axisymmetric: the first quadrant points with x < y from their transposes */
+   if(axial){
+	#pragma omp parallel for num_threads(threads) private(col, d)
+	for(row = 0; row <= N_Y/2; ++row){
+	    double value[3];
+
+	    for(col = 0; col < row && col <= N_X/2; ++col){
+		if( row > N_X/2 || (kernel_radius >= 0 && col*col + row*row > kernel_radius*kernel_radius) ){
+			continue;
+		}
+		for(d = 0; d < displacement_dimensions; ++d){
+			value[d] = green_buffer_at(model_buffer, model_buffer_f, 
+			                           (d == x_index ? y_index : (d == y_index ? x_index : d)), row+N_XR*col);
+		}
+		green_buffer_set(model_buffer, model_buffer_f, col+N_XR*row, value);
+	    }
+	}
+   }
+
+   /* the other quadrants from the first one */
+   if(mirror){
+	#pragma omp parallel for num_threads(threads) private(col, dx, dy, q, d)
+	for(row = 0; row < N_Y; ++row){
+	    double value[3];
+
+	    for(col = 0; col < N_X; ++col){
+		dx = (col <= N_X/2 ? col : N_X-col);
+		dy = (row <= N_Y/2 ? row : N_Y-row);
+
+		if( (col <= N_X/2 && row <= N_Y/2) || (kernel_radius >= 0 && dx*dx + dy*dy > kernel_radius*kernel_radius) ){
+			continue;
+		}
+		q = (col <= N_X/2 ? 2 : (row > N_Y/2 ? 3 : 4));
+		for(d = 0; d < displacement_dimensions; ++d){
+			value[d] = sign[q][d] * green_buffer_at(model_buffer, model_buffer_f, d, dx+N_XR*dy);
+		}
+		green_buffer_set(model_buffer, model_buffer_f, col+N_XR*row, value);
+	    }
+	}
+   }
+
+   q = -1;
+   while(++q < threads){
+	crusde_free_green_workspace(workspace[q]);
+   }
+   free(workspace);
+}
+
+//! Samples the Green's function on the operator space
+/** 
+ * Requests values for each point of the operator space from Green's function and does the 
+ * origin shifting necessary for the convolution. The Green's function values are requested 
+ * for each displacement direction the Green's function registered with the CrusDe and 
+ * written to model_buffer[direction][x+N_XR*y], i.e. in the padded layout of an in-place DFT.
+ * model_buffer_f receives the same values in single precision. Either buffer may be NULL.
+ * Beyond kernel_radius the Green's function is not evaluated but set to 0.
+ * If the Green's function declares a symmetry (see fft_mirror_signs()), it is evaluated in the
+ * first quadrant only; the other quadrants are mirrored from the values already written to 
+ * the buffer, which is a quarter of the Green's function evaluations.
+ * Reentrant Green's functions are sampled row by row by all threads, see sample_green_rows().
+ */
+static void sample_green(double **model_buffer, float **model_buffer_f)
 {   
+   int dx, dy, quadrant, mirror;
+   double sign[5][3];
 
-   RESET(x,y);
-      
-   /* 
-    * first, get the impulse response, this needs to be done only once, that's why there are two
-    * double whiles ... a little inconvenient when modeling only one timestep, but effective for 
-    * the other 364 ... depending on whether the Green's function is time dependent though
-    */
+   if(crusde_green_is_reentrant()){
+	sample_green_rows(model_buffer, model_buffer_f);
+	return;
+   }
 
-    t = crusde_model_time();    
+   /* the signs do not depend on the point, get them once per quadrant */
+   mirror = 1;
+   quadrant = 0;
+   while(++quadrant <= 4){
+	mirror = mirror && fft_mirror_signs(quadrant, sign[quadrant]);
+   }
 
-    if(t == 0 ){
+   RESET(x,y);
 
-      while(++y < N_Y){
-        x = -1;
-        while(++x < N_X){
-            
-//          if(green_initialized == false) 
-//          {
+   while(++y < N_Y){
+	x = -1;
+	while(++x < N_X){
+	    /* distance of the point from the origin after the origin shift */
+	    dx = (x <= N_X/2 ? x : N_X-x);
+	    dy = (y <= N_Y/2 ? y : N_Y-y);
 
-            if( (x <= N_X/2) && (y <= N_Y/2) ){
+	    if( kernel_radius >= 0 && dx*dx + dy*dy > kernel_radius*kernel_radius ){
+			n=-1;
+			while(++n < displacement_dimensions){
+				green_back[n]=0.0;
+			}
+	    }
+	    else if( (x <= N_X/2) && (y <= N_Y/2) ){
 			/*set quadrant we're in, in case of cylindrical:carthesian conversion in green's function*/
 			crusde_set_quadrant(1);
 			crusde_get_green_at(&green_back,x,y);
 	    }
+	    else if( mirror ){
+			/* (dx,dy) lies in the first quadrant, which precedes (x,y) in the buffer */
+			quadrant = (x <= N_X/2 ? 2 : (y > N_Y/2 ? 3 : 4));
+			n=-1;
+			while(++n < displacement_dimensions){
+				green_back[n] = sign[quadrant][n] * (model_buffer != NULL ? model_buffer[n][dx+N_XR*dy] 
+				                                                          : (double) model_buffer_f[n][dx+N_XR*dy]);
+			}
+	    }
 	    else{
 			/* do origin shift (see paper)*/
 			if( (x <= N_X/2 ) && (y > N_Y/2) ){
@@ -286,80 +905,917 @@ extern void run()
 			}
 	    }
 			
-            /*copy results to model buffer*/
+	    /*copy results to model buffer*/
 	    n=-1;
-            while(++n<displacement_dimensions){
-			model_buffer[n][x+N_X*y] = green_back[n];
+	    while(++n<displacement_dimensions){
+			if(model_buffer != NULL)
+				model_buffer[n][x+N_XR*y] = green_back[n];
+			if(model_buffer_f != NULL)
+				model_buffer_f[n][x+N_XR*y] = (float) green_back[n];
 	    }
+	}//end while N_X
+   }//end while N_Y
+}
 
-	    /*third, get the load and do zero padding ... the load is the thing that is time dependent*/
-            if( (x < size_x) && (y < size_y) ){
-			load_in[x+N_X*y] = crusde_get_load_at(x, y);
-	    }
-	    else{
-			load_in[x+N_X*y] = 0.0;
-	    }
-	 }//end while N_Y
-      }//end while N_X
-    
-//    green_initialized=true; 
 
-   }/*model time == 0*/
-   else{
-	/*second, get the load and do zero padding ... the load is the thing that is time dependent*/
-	while(++y <= N_Y){
-		x = -1;
-		while(++x <= N_X){
-			if( (x <= size_x) && (y <= size_y) ){
-				load_in[x+N_X*y] = crusde_get_load_at(x, y);
-			}
-			//zero pad remains from first model step
-		}
-	}
+//! Fills the spectrum blocks of entry from the closed form spectrum of the Green's function
+/** 
+ * Column col and row row of the half spectrum belong to the wavenumbers 2*pi*col/(N_X*gridsize) 
+ * and 2*pi*row/(N_Y*gridsize), rows above N_Y/2 to negative ones. The Green's function is 
+ * truncated to spectrum_radius, its spectrum is scaled by 1/N like the sampled one.
+ * With green_transform = 'r2r' the rows up to N_Y/2 are filled into the quarters: the spectrum 
+ * of an even component is real, that of an odd one is -i times its quarter (see convolve()).
+ */
+static void analytic_green(green_spectrum *entry)
+{
+   double gridsize = crusde_get_gridsize();
+   double *re_back = (double*) malloc(sizeof(double) * displacement_dimensions);
+   double *im_back = (double*) malloc(sizeof(double) * displacement_dimensions);
+   int rows = (use_r2r ? N_QY : N_Y);
+   int row, col, k;
+   double value;
+
+   if(re_back == NULL || im_back == NULL){
+	crusde_bad_alloc();
    }
 
-   crusde_info("(%s) Convolution of Green's function and load ...", get_name());
+   row = -1;
+   while(++row < rows){
+	col = -1;
+	while(++col < N_XC){
+		crusde_get_green_spectrum_at(&re_back, &im_back, 
+		                             2.0*M_PI*col / (N_X*gridsize), 
+		                             2.0*M_PI*(row <= N_Y/2 ? row : row-N_Y) / (N_Y*gridsize), 
+		                             spectrum_radius*gridsize);
 
-   /* transform green's function results and load values to frequency domain */
-   fftw_execute(load_plan);
-   	
+		n=-1;
+		while(++n < displacement_dimensions){
+			if(use_r2r){
+				k = col + N_QX*row + n*N_Q;
+				value = (n == crusde_get_x_index() || n == crusde_get_y_index() ? -im_back[n] : re_back[n]) / N;
+
+				if(entry->quarter != NULL)
+					entry->quarter[k]   = value;
+				if(entry->quarter_f != NULL)
+					entry->quarter_f[k] = (float) value;
+				continue;
+			}
+
+			k = col + N_XC*row + n*N_C;
+
+			if(entry->block != NULL)
+				entry->block[k]   = (re_back[n] + I*im_back[n]) / N;
+			if(entry->block_f != NULL)
+				entry->block_f[k] = (float) (re_back[n] / N) + I * (float) (im_back[n] / N);
+		}
+	}
+   }
+
+   free(re_back);
+   free(im_back);
+}
+
+//! Transforms the Green's function samples in conv_out (conv_out_f) to the quarters of entry
+/** 
+ * Under a symmetry (see fft_mirror_signs()) each displacement dimension of the sampled Green's 
+ * function is even or odd along each axis, so is its spectrum, which is real for an even 
+ * component and imaginary for an odd one. The quadrant x, y >= 0 of the samples is copied to 
+ * the quarter and transformed in-place: along an axis the component is even in with a REDFT00 
+ * of N/2+1 values, which is the DFT of the even extension of length N, along an axis it is odd in 
+ * with a RODFT00 of the N/2-1 values between the zeros of the odd extension. The result is the 
+ * quadrant kx, ky >= 0 of the spectrum, -i times it for an odd component, on a quarter of the 
+ * memory of the half spectrum and of the transform size. It is scaled by 1/N.
+ */
+static void transform_quarter(green_spectrum *entry)
+{
+   /* loop variables of the parallel loops, the global ones would be shared between threads */
+   int row, col, odd_x, odd_y;
+   double *quarter;
+   float  *quarter_f;
 
    n=-1;
-   while(++n < displacement_dimensions){   
+   while(++n < displacement_dimensions){
+	odd_x = (n == crusde_get_x_index());
+	odd_y = (n == crusde_get_y_index());
+
+	if(use_double){
+		quarter = entry->quarter + n*N_Q;
+
+		#pragma omp parallel for num_threads(threads) private(col)
+		for(row = 0; row < N_QY; ++row){
+			for(col = 0; col < N_QX; ++col){
+				quarter[col+N_QX*row] = conv_out[col+N_XR*row + n*2*N_C];
+			}
+		}
+
+		fftw_execute_r2r(green_r2r[n], quarter + quarter_offset(n), quarter + quarter_offset(n));
+
+		/* the odd extension vanishes on the axis and at N/2, so does its spectrum */
+		#pragma omp parallel for num_threads(threads) private(col)
+		for(row = 0; row < N_QY; ++row){
+			for(col = 0; col < N_QX; ++col){
+				if( (odd_x && (col == 0 || col == N_QX-1)) || (odd_y && (row == 0 || row == N_QY-1)) )
+					quarter[col+N_QX*row] = 0.0;
+				else
+					quarter[col+N_QX*row] /= N;
+			}
+		}
+	}
+
+	if(use_single){
+		quarter_f = entry->quarter_f + n*N_Q;
+
+		#pragma omp parallel for num_threads(threads) private(col)
+		for(row = 0; row < N_QY; ++row){
+			for(col = 0; col < N_QX; ++col){
+				quarter_f[col+N_QX*row] = conv_out_f[col+N_XR*row + n*2*N_C];
+			}
+		}
+
+		fftwf_execute_r2r(green_r2r_f[n], quarter_f + quarter_offset(n), quarter_f + quarter_offset(n));
+
+		#pragma omp parallel for num_threads(threads) private(col)
+		for(row = 0; row < N_QY; ++row){
+			for(col = 0; col < N_QX; ++col){
+				if( (odd_x && (col == 0 || col == N_QX-1)) || (odd_y && (row == 0 || row == N_QY-1)) )
+					quarter_f[col+N_QX*row] = 0.0f;
+				else
+					quarter_f[col+N_QX*row] /= N;
+			}
+		}
+	}
+   }
+}
+
+//! Adds a new, empty spectrum for plugin and job to the cache
+/** 
+ * The blocks are allocated in each precision that was set up in init(), the quarters instead 
+ * of the half spectra with green_transform = 'r2r'.
+ */
+static green_spectrum* new_spectrum(const char *plugin, const char *job)
+{   
+   green_spectrum *entry = (green_spectrum*) malloc(sizeof(green_spectrum));
+   if(entry == NULL){ crusde_bad_alloc(); }
+
+   entry->plugin   = (char*) malloc(strlen(plugin)+1);
+   entry->job      = (char*) malloc(strlen(job)+1);
+
+   if(entry->plugin == NULL || entry->job == NULL){
+	crusde_bad_alloc();
+   }
 
-   	//fill input array with values   	
-	i = -1;
-	while(++i < N){
-		green_in[i] = model_buffer[n][i];
+   strcpy(entry->plugin, plugin);
+   strcpy(entry->job, job);
+   entry->gridsize = crusde_get_gridsize();
+   entry->size_x   = size_x;
+   entry->size_y   = size_y;
+   entry->n_x      = N_X;
+   entry->n_y      = N_Y;
+   entry->block    = NULL;
+   entry->block_f  = NULL;
+   entry->quarter  = NULL;
+   entry->quarter_f= NULL;
+
+   if(use_double && use_r2r){
+	entry->quarter = (double*) fftw_malloc(sizeof(double) * N_Q * displacement_dimensions);
+	if(entry->quarter == NULL){ crusde_bad_alloc(); }
+   }
+   else if(use_double){
+	entry->block = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * N_C * displacement_dimensions);
+	if(entry->block == NULL){ crusde_bad_alloc(); }
+   }
+
+   if(use_single && use_r2r){
+	entry->quarter_f = (float*) fftwf_malloc(sizeof(float) * N_Q * displacement_dimensions);
+	if(entry->quarter_f == NULL){ crusde_bad_alloc(); }
+   }
+   else if(use_single){
+	entry->block_f = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * N_C * displacement_dimensions);
+	if(entry->block_f == NULL){ crusde_bad_alloc(); }
+   }
+
+   entry->next = spectrum_cache;
+   spectrum_cache = entry;
+
+   return entry;
+}
+
+//! Looks up the cache for a spectrum of plugin and job on the current grid and operator space, NULL if there is none
+static green_spectrum* find_spectrum(const char *plugin, const char *job)
+{   
+   int gridsize = crusde_get_gridsize();
+   green_spectrum *entry = spectrum_cache;
+
+   while(entry != NULL){
+	if( entry->gridsize == gridsize && 
+	    entry->size_x == size_x && entry->size_y == size_y &&
+	    entry->n_x == N_X && entry->n_y == N_Y &&
+	    strcmp(entry->plugin, plugin) == 0 && strcmp(entry->job, job) == 0 ){
+		return entry;
+	}
+	entry = entry->next;
+   }
+
+   return NULL;
+}
+
+//! Returns the spectrum of the Green's function plugin that is currently evaluated
+/** 
+ * Looks up the cache for a spectrum that was computed for the same Green's function plugin, 
+ * grid and operator space. On a miss the Green's function is sampled, transformed 
+ * to the frequency domain with the 1/N normalization of the inverse DFT folded in, and 
+ * added to the cache. The spectrum is computed in each precision that was set up in init().
+ * If the Green's function has a spectrum in closed form (green_spectrum = 'analytic'), it is 
+ * filled in directly by analytic_green() instead, without sampling and forward DFTs.
+ * The spectrum does not depend on the job, all jobs using the plugin share it.
+ * With green_transform = 'r2r' the Green's function must declare a symmetry; it is sampled to 
+ * the scratch space of conv_out and only its quarter is transformed (see transform_quarter()).
+ */
+static green_spectrum* plugin_spectrum()
+{   
+   const char *plugin = crusde_get_current_green_plugin();
+
+   green_spectrum *entry = find_spectrum(plugin, "");
+   double **model_buffer   = NULL;
+   float  **model_buffer_f = NULL;
+   int k;
+
+   if(entry != NULL){
+	return entry;
+   }
+
+   crusde_info("(%s) computing spectrum of Green's function '%s' ...", get_name(), plugin);
+
+   if(use_r2r && crusde_get_green_symmetry() == NO_SYMMETRY){
+	crusde_error("(%s) green_transform 'r2r' needs a Green's function with a symmetry, '%s' has none (use 'dft')", get_name(), plugin);
+   }
+
+   entry = new_spectrum(plugin, "");
+
+   /* the Green's function is sampled straight into the spectrum blocks, which are transformed in-place */
+   /* the quarters are smaller than the samples, these go to conv_out, which is not in use between convolutions */
+   if(use_double){
+	model_buffer = (double**) malloc(sizeof(double*) * displacement_dimensions);
+	if(model_buffer == NULL){ crusde_bad_alloc(); }
+
+	n=-1;
+	while(++n < displacement_dimensions){
+		model_buffer[n] = (use_r2r ? conv_out + n*2*N_C : (double*) (entry->block + n*N_C));
 	}
-	   
-	fftw_execute(green_plan);
+   }
 
-	/* ----------------------------------------------------------------- */
-	/* convolution in space domain == multiplication in frequency domain */
-	/* ----------------------------------------------------------------- */
-	
-	i = -1;
-	while(++i < N){
+   if(use_single){
+	model_buffer_f = (float**) malloc(sizeof(float*) * displacement_dimensions);
+	if(model_buffer_f == NULL){ crusde_bad_alloc(); }
+
+	n=-1;
+	while(++n < displacement_dimensions){
+		model_buffer_f[n] = (use_r2r ? conv_out_f + n*2*N_C : (float*) (entry->block_f + n*N_C));
+	}
+   }
+
+   if(use_analytic){
+	analytic_green(entry);
+   }
+   else{
+	sample_green(model_buffer, model_buffer_f);
+
+	if(use_r2r){
+		transform_quarter(entry);
+	}
+   }
+
+   /* all components in one batch, scaled by 1/N once, the inverse DFT of FFTW is unnormalized */
+   if(use_double){
+	if(!use_analytic && !use_r2r){
+		fftw_execute_dft_r2c(green_plan, (double*) entry->block, entry->block);
+
+		#pragma omp parallel for num_threads(threads)
+		for(k = 0; k < N_C * displacement_dimensions; ++k){
+			entry->block[k] /= N;
+		}
+	}
+
+	free(model_buffer);
+   }
+
+   if(use_single){
+	if(!use_analytic && !use_r2r){
+		fftwf_execute_dft_r2c(green_plan_f, (float*) entry->block_f, entry->block_f);
+
+		#pragma omp parallel for num_threads(threads)
+		for(k = 0; k < N_C * displacement_dimensions; ++k){
+			entry->block_f[k] /= N;
+		}
+	}
+
+	free(model_buffer_f);
+   }
+
+   return entry;
+}
+
+//! Returns the spectrum of the Green's function of the current job
+/** 
+ * A job of a single plugin uses the plugin's spectrum (see plugin_spectrum()). A job that is 
+ * a weighted sum of plugins (see crusde_get_green_components()) gets the weighted sum of their 
+ * spectra, which is cached for the job. Each plugin is thus sampled and transformed once, 
+ * however many jobs it appears in.
+ */
+static green_spectrum* get_green_spectrum()
+{   
+   const char *plugin = crusde_get_current_green_plugin();
+   const char *job    = crusde_get_current_job();
+   int components     = crusde_get_green_components();
+
+   green_spectrum *entry, *part;
+   double weight;
+   int c, k;
+
+   if(components == 1 && crusde_select_green_component(0) == 1.0){
+	entry = plugin_spectrum();
+	crusde_select_green_component(-1);
+	return entry;
+   }
+   crusde_select_green_component(-1);
+
+   entry = find_spectrum(plugin, job);
+   if(entry != NULL){
+	return entry;
+   }
+
+   crusde_info("(%s) adding spectra of Green's function '%s' for job '%s' ...", get_name(), plugin, job);
+
+   entry = new_spectrum(plugin, job);
+
+   c = -1;
+   while(++c < components){
+	weight = crusde_select_green_component(c);
+	part   = plugin_spectrum();
+
+	#pragma omp parallel for num_threads(threads)
+	for(k = 0; k < N_C * displacement_dimensions; ++k){
+		if(entry->block != NULL)
+			entry->block[k]   = (c == 0 ? 0.0 : entry->block[k]) + weight * part->block[k];
+		if(entry->block_f != NULL)
+			entry->block_f[k] = (c == 0 ? 0.0f : entry->block_f[k]) + (float) weight * part->block_f[k];
+	}
+
+	#pragma omp parallel for num_threads(threads)
+	for(k = 0; k < N_Q * displacement_dimensions; ++k){
+		if(entry->quarter != NULL)
+			entry->quarter[k]   = (c == 0 ? 0.0 : entry->quarter[k]) + weight * part->quarter[k];
+		if(entry->quarter_f != NULL)
+			entry->quarter_f[k] = (c == 0 ? 0.0f : entry->quarter_f[k]) + (float) weight * part->quarter_f[k];
+	}
+   }
+   crusde_select_green_component(-1);
+
+   return entry;
+}
+
+//! Row of the quarter and factor that give row 'row' of the half spectrum of displacement dimension d
+/** 
+ * With green_transform = 'r2r' the Green's function spectrum at (kx, ky) is taken from its quarter 
+ * at (kx, |ky|): as it is for an even component, times -i for a component odd in x, times 
+ * -i sign(ky) for one odd in y (see transform_quarter()). Rows above N_Y/2 belong to negative ky.
+ */
+static double complex quarter_row(int d, int row, int *source)
+{
+   double complex factor = (d == crusde_get_x_index() || d == crusde_get_y_index() ? -I : 1.0);
+
+   if(row <= N_Y/2){
+	*source = row;
+	return factor;
+   }
+
+   *source = N_Y - row;
+   return (d == crusde_get_y_index() ? -factor : factor);
+}
+
+//! Multiplies the load spectrum with the Green's function spectrum of each displacement dimension, double precision
+/** 
+ * The products of all dimensions are written to conv back to back, N_C values apart, by a team of
+ * 'team' threads. Quarters of the Green's function spectrum are expanded with quarter_row().
+ */
+static void multiply(green_spectrum *green, const fftw_complex *load, fftw_complex *conv, int team)
+{   
+   /* loop variables of the parallel loops, the global ones would be shared between threads */
+   int row, col, k, d, source;
+   fftw_complex *spectrum, *green_d, factor;
+   double *quarter;
+
+   for(d = 0; d < displacement_dimensions; ++d){   
+	spectrum = conv + d*N_C;
+
+	if(green->quarter != NULL){
+		#pragma omp parallel for num_threads(team) if(team > 1) private(col, k, source, factor, quarter)
+		for(row = 0; row < N_Y; ++row){
+			factor  = quarter_row(d, row, &source);
+			quarter = green->quarter + d*N_Q + N_QX*source;
+
+			for(col = 0; col < N_XC; ++col){
+				k = col + N_XC*row;
+				spectrum[k] = factor * quarter[col] * load[k];
+			}
+		}
+		continue;
+	}
+
+	green_d  = green->block + d*N_C;
+
+	#pragma omp parallel for num_threads(team) if(team > 1)
+	for(k = 0; k < N_C; ++k){
 		/*we're using <complex.h>*/
 		/*complex multiplication is z1z2 = (a1 + ib1) (a2 + ib2) = (a1a2 - b1b2) + i(a1b2 + b1a2)*/
-		conv_in[i] = (green_out[i] * load_out[i]) / N;
-	}
-	
-	/* inverse transform of the result (back to space domain) */
-	fftw_execute(conv_plan);
-	
-	RESET(x,y);
-	/*extract region of interest from conv_result ... remove zero-pad*/
-	while(++y < size_y){
-		x = -1;
-		while(++x < size_x){
-			result[n][(int) (x+size_x*y)] = conv_out[x+N_X*y];
+		spectrum[k] = green_d[k] * load[k];
+	}
+   }
+}
+
+//! Convolution of the load in load_in with the Green's function spectra, double precision
+/** 
+ * The load is transformed, multiplied with the half spectrum of each displacement dimension
+ * (see multiply()) and all products are transformed back in one batch. The region of interest 
+ * is written to out[dimension].
+ */
+static void convolve(green_spectrum *green, double **out)
+{   
+   /* loop variables of the parallel loops, the global ones would be shared between threads */
+   int row, col;
+   double *real;
+
+   /* transform load values to frequency domain */
+   fftw_execute(load_plan);
+
+   /* ----------------------------------------------------------------- */
+   /* convolution in space domain == multiplication in frequency domain */
+   /* ----------------------------------------------------------------- */
+   multiply(green, load_out, conv_in, threads);
+
+   /* inverse transform of the results of all dimensions (back to space domain) */
+   fftw_execute(conv_plan);
+
+   /*extract region of interest from conv_result ... remove zero-pad*/
+   n=-1;
+   while(++n < displacement_dimensions){   
+	real = conv_out + n*2*N_C;
+
+	#pragma omp parallel for num_threads(threads) private(col)
+	for(row = 0; row < size_y; ++row){
+		for(col = 0; col < size_x; ++col){
+			out[n][col+size_x*row] = real[col+N_XR*row];
+		}
+	}
+   }
+}
+
+//! Same as convolve() on the single precision buffers, the region of interest is written as double
+static void convolve_single(green_spectrum *green, double **out)
+{   
+   int row, col, k, source;
+   fftwf_complex *spectrum, *green_n, factor;
+   float *real, *quarter;
+
+   fftwf_execute(load_plan_f);
+
+   n=-1;
+   while(++n < displacement_dimensions){   
+	spectrum = conv_in_f + n*N_C;
+
+	if(green->quarter_f != NULL){
+		#pragma omp parallel for num_threads(threads) private(col, k, source, factor, quarter)
+		for(row = 0; row < N_Y; ++row){
+			factor  = (fftwf_complex) quarter_row(n, row, &source);
+			quarter = green->quarter_f + n*N_Q + N_QX*source;
+
+			for(col = 0; col < N_XC; ++col){
+				k = col + N_XC*row;
+				spectrum[k] = factor * quarter[col] * load_out_f[k];
+			}
+		}
+		continue;
+	}
+
+	green_n  = green->block_f + n*N_C;
+
+	#pragma omp parallel for num_threads(threads)
+	for(k = 0; k < N_C; ++k){
+		spectrum[k] = green_n[k] * load_out_f[k];
+	}
+   }
+
+   fftwf_execute(conv_plan_f);
+
+   n=-1;
+   while(++n < displacement_dimensions){   
+	real = conv_out_f + n*2*N_C;
+
+	#pragma omp parallel for num_threads(threads) private(col)
+	for(row = 0; row < size_y; ++row){
+		for(col = 0; col < size_x; ++col){
+			out[n][col+size_x*row] = (double) real[col+N_XR*row];
+		}
+	}
+   }
+}
+
+//! Reports the deviation of the single precision results from the double precision results
+/** 
+ * For each displacement dimension the maximum absolute difference is given, absolute and
+ * relative to the maximum absolute value of the double precision result.
+ */
+static void report_deviation()
+{   
+   double diff, max_diff, max_ref;
+   int k;
+
+   n=-1;
+   while(++n < displacement_dimensions){   
+	max_diff = 0.0;
+	max_ref  = 0.0;
+
+	for(k = 0; k < size_x*size_y; ++k){
+		diff = fabs(result[n][k] - reference[n][k]);
+		if(diff > max_diff)                 max_diff = diff;
+		if(fabs(reference[n][k]) > max_ref) max_ref  = fabs(reference[n][k]);
+	}
+
+	crusde_info("(%s) single vs. double precision, dimension %d: max. deviation %.3e (relative %.3e)",
+	            get_name(), n, max_diff, (max_ref > 0.0 ? max_diff/max_ref : 0.0));
+   }
+}
+
+//! Returns 'true' if the load in load_now is base_load times a scalar, which is written to *scale
+/** 
+ * The scale is taken from the first non-zero value of base_load; all values must then match
+ * to SCALE_TOLERANCE. A load that is zero everywhere matches only a base load that is zero, too.
+ */
+static boolean is_multiple_of_base(double *scale)
+{
+   boolean found = false;
+   int k;
+
+   *scale = 1.0;
+
+   for(k = 0; k < size_x*size_y; ++k){
+	if(!found && base_load[k] != 0.0){
+		*scale = load_now[k] / base_load[k];
+		found  = true;
+	}
+	if( fabs(load_now[k] - *scale * base_load[k]) > SCALE_TOLERANCE * fabs(load_now[k]) ){
+		return false;
+	}
+   }
+
+   return true;
+}
+
+//! Performs the fast convolution
+/** 
+ * Requests the spectrum of the Green's function from the cache (it is computed only once per
+ * job, see get_green_spectrum()) and the load function values for the region of interest on
+ * every call.
+ * 
+ * On the first call the DFTs are set up if this was deferred to choose the kernel radius 
+ * from kernel_tolerance (see init()).
+ * 
+ * If the load equals the load of the last convolution, or is a multiple of it, and the Green's 
+ * function spectrum is the same, the last convolution result is scaled instead of convolving 
+ * again. Static loads and loads that only vary by a load history are convolved once per job.
+ * With precision 'compare' every load is convolved, both paths are measured on each call.
+ * 
+ * Otherwise the FFTW plan is executed for the load. Then for each Green's function displacement 
+ * direction a complex multiplication of the half spectra is performed and for all products the 
+ * batched FFTW plan is executed at once (IDFT). The result of the convolution is extracted from 
+ * the oversized IDFT result and cropped to the original size of the examined region. The 
+ * transforms and the element-wise loops run on 'threads' threads, only the load function is 
+ * evaluated serially. Depending on the precision parameter this is done in double precision 
+ * (convolve()), single precision (convolve_single()), or both.
+ * 
+ * CAN ONLY BE USE FOR ONE LOAD (i.e. multiple loads in one load file), to realize reuse of this 
+ * operator in fast_conv_time_space - the loads want to have independent load histories!
+ */
+extern void run()
+{   
+   green_spectrum *green;
+   /* loop variables of the parallel loops, the global ones would be shared between threads */
+   int row, col, k;
+   double scale, *swap;
+
+   /* the kernel radius is chosen from the Green's function of the first job */
+   if(!is_planned){
+	kernel_radius = fft_kernel_radius(0.0, *p_kernel_tolerance, max_offset());
+	setup_transforms();
+   }
+
+   green = get_green_spectrum();
+
+   /* get the load, the thing that is time dependent ... the load function is not thread safe */
+   RESET(x,y);
+   while(++y < size_y){
+	x = -1;
+	while(++x < size_x){
+		load_now[x+size_x*y] = crusde_get_load_at(x, y);
+	}
+   }
+
+   /* same Green's function and same load up to a factor: scale the last result ... */
+   /* not with precision 'compare', which reports the deviation on every call */
+   if(!(use_single && use_double) && green == base_green && is_multiple_of_base(&scale)){
+	crusde_info("(%s) load is %g times the last convolved load, scaling its result ...", get_name(), scale);
+
+	n=-1;
+	while(++n < displacement_dimensions){
+		#pragma omp parallel for num_threads(threads)
+		for(k = 0; k < size_x*size_y; ++k){
+			result[n][k] = scale * base_result[n][k];
 		}
 	}
 
+	crusde_set_result(result);
+	return;
+   }
+
+   /* copy the load to the DFT input, zero padding ... the in-place DFT of the previous call overwrote it */
+   #pragma omp parallel for num_threads(threads) private(col)
+   for(row = 0; row < N_Y; ++row){
+	for(col = 0; col < N_X; ++col){
+		if(use_double) load_in[col+N_XR*row]   = (row < size_y && col < size_x ? load_now[col+size_x*row] : 0.0);
+		if(use_single) load_in_f[col+N_XR*row] = (row < size_y && col < size_x ? (float) load_now[col+size_x*row] : 0.0f);
+	}
+   }
+
+   crusde_info("(%s) Convolution of Green's function and load ...", get_name());
+
+   if(use_single){
+	convolve_single(green, result);
+
+	if(use_double){
+		convolve(green, reference);
+		report_deviation();
+	}
+   }
+   else{
+	convolve(green, result);
+   }
+
+   /* this load and its result are the base for the next calls */
+   swap      = base_load;
+   base_load = load_now;
+   load_now  = swap;
+   base_green = green;
+
+   n=-1;
+   while(++n < displacement_dimensions){
+	memcpy(base_result[n], result[n], sizeof(double) * size_x * size_y);
    }
 
    /* give result to main application */
    crusde_set_result(result);
 }
+
+//! Sets up buffers of each thread and plans for one thread for convolve_loads()
+/** 
+ * The buffers have the layout of load_out and conv_in, the plans are those of load_plan and 
+ * conv_plan, made for one thread: each thread transforms a load of its own, FFTW plans can be 
+ * executed on other buffers of the same alignment by several threads at once.
+ */
+static void setup_batch()
+{
+   int shape[2], real_shape[2], complex_shape[2];
+
+   shape[0] = N_Y;		shape[1] = N_X;
+   real_shape[0] = N_Y;		real_shape[1] = N_XR;
+   complex_shape[0] = N_Y;	complex_shape[1] = N_XC;
+
+   batch_load_in  = (double**) malloc(sizeof(double*) * threads);
+   batch_load_out = (fftw_complex**) malloc(sizeof(fftw_complex*) * threads);
+   batch_conv_in  = (fftw_complex**) malloc(sizeof(fftw_complex*) * threads);
+   batch_conv_out = (double**) malloc(sizeof(double*) * threads);
+
+   if(batch_load_in == NULL || batch_load_out == NULL || batch_conv_in == NULL || batch_conv_out == NULL){
+	crusde_bad_alloc();
+   }
+
+   n=-1;
+   while(++n < threads){
+	batch_load_out[n] = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * N_C);
+	batch_conv_in[n]  = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * N_C * displacement_dimensions);
+
+	if(batch_load_out[n] == NULL || batch_conv_in[n] == NULL){
+		crusde_bad_alloc();
+	}
+
+	batch_load_in[n]  = (double*) batch_load_out[n];
+	batch_conv_out[n] = (double*) batch_conv_in[n];
+   }
+
+   crusde_info("(%s) planning FFT for batches of %d loads ...", get_name(), threads);
+
+   fftw_plan_with_nthreads(1);
+   batch_load_plan = fftw_plan_dft_r2c_2d(N_Y, N_X, batch_load_in[0], batch_load_out[0], planner_flags);
+   batch_conv_plan = fftw_plan_many_dft_c2r(2, shape, displacement_dimensions,
+                                            batch_conv_in[0], complex_shape, 1, N_C,
+                                            batch_conv_out[0], real_shape, 1, 2*N_C, planner_flags);
+   fftw_plan_with_nthreads(threads);
+
+   if(planner_flags != FFTW_ESTIMATE){
+	fft_export_wisdom();
+   }
+
+   is_batched = true;
+}
+
+//! Convolves loads 0 ... loads-1 with the Green's function of the current job, 'threads' loads at a time
+/** 
+ * The result of load l, displacement dimension d goes to out[l][d], size_x*size_y values allocated 
+ * by the caller. The loads of a batch are sampled one after another (the load function is not 
+ * thread safe, see crusde_set_current_load_component()), then each thread transforms one of them, 
+ * multiplies it with the cached Green's function spectrum and transforms the products back. Each 
+ * load is convolved by one thread with the same plans, the results do not depend on the number 
+ * of threads. Afterwards the core's result points to the result of this plugin, which is free
+ * to be overwritten.
+ * 
+ * Returns 'false' without convolving if precision is not 'double'; the caller then convolves load 
+ * by load with run().
+ */
+extern boolean convolve_loads(int loads, double ***out)
+{
+   green_spectrum *green;
+   /* loop variables of the parallel loops, the global ones would be shared between threads */
+   int first, count, b, row, col, d;
+
+   if(use_single){
+	return false;
+   }
+
+   /* the kernel radius is chosen from the Green's function of the first job */
+   if(!is_planned){
+	kernel_radius = fft_kernel_radius(0.0, *p_kernel_tolerance, max_offset());
+	setup_transforms();
+   }
+
+   if(!is_batched){
+	setup_batch();
+   }
+
+   green = get_green_spectrum();
+
+   crusde_info("(%s) Convolution of Green's function and %d loads ...", get_name(), loads);
+
+   for(first = 0; first < loads; first += threads){
+	count = (loads - first < threads ? loads - first : threads);
+
+	/* get the loads of this batch, zero padding */
+	for(b = 0; b < count; ++b){
+		crusde_set_current_load_component(first + b);
+
+		RESET(x,y);
+		while(++y < N_Y){
+			x = -1;
+			while(++x < N_X){
+				batch_load_in[b][x+N_XR*y] = (y < size_y && x < size_x ? crusde_get_load_at(x, y) : 0.0);
+			}
+		}
+	}
+
+	#pragma omp parallel for num_threads(threads) schedule(static, 1) private(row, col, d)
+	for(b = 0; b < count; ++b){
+		fftw_execute_dft_r2c(batch_load_plan, batch_load_in[b], batch_load_out[b]);
+		multiply(green, batch_load_out[b], batch_conv_in[b], 1);
+		fftw_execute_dft_c2r(batch_conv_plan, batch_conv_in[b], batch_conv_out[b]);
+
+		for(d = 0; d < displacement_dimensions; ++d){
+			for(row = 0; row < size_y; ++row){
+				for(col = 0; col < size_x; ++col){
+					out[first+b][d][col+size_x*row] = batch_conv_out[b][col+N_XR*row + d*2*N_C];
+				}
+			}
+		}
+	}
+   }
+
+   crusde_set_result(result);
+
+   return true;
+}
+
+//! Transforms loads 0 ... loads-1 and returns the Green's function spectrum of the current job
+/** 
+ * For 'fast 3d convolution', which sums the loads weighted by their histories in the spectral 
+ * domain and convolves the sum with convolve_transformed(), one inverse DFT per timestep instead 
+ * of one per load. The load spectra are kept until clear(), all jobs share them; they are 
+ * computed again only if the number of loads changes. The returned spectrum is the handle for 
+ * convolve_transformed(), it stays in the cache until clear(). Afterwards the core's result 
+ * points to the result of this plugin, which is free to be overwritten.
+ * 
+ * Returns NULL if precision is not 'double'; the caller then convolves load by load with run().
+ */
+extern void* transform_loads(int loads)
+{
+   green_spectrum *green;
+   int l;
+
+   if(use_single){
+	return NULL;
+   }
+
+   /* the kernel radius is chosen from the Green's function of the first job */
+   if(!is_planned){
+	kernel_radius = fft_kernel_radius(0.0, *p_kernel_tolerance, max_offset());
+	setup_transforms();
+   }
+
+   green = get_green_spectrum();
+
+   if(load_spectra == NULL || spectra_loads != loads){
+	l=-1;
+	while(++l < spectra_loads){
+		fftw_free(load_spectra[l]);
+	}
+	free(load_spectra);
+
+	load_spectra  = (fftw_complex**) malloc(sizeof(fftw_complex*) * loads);
+	spectra_loads = loads;
+
+	if(load_spectra == NULL){
+		crusde_bad_alloc();
+	}
+
+	crusde_info("(%s) transforming %d loads ...", get_name(), loads);
+
+	/* the load function is not thread safe, the transforms are threaded */
+	l=-1;
+	while(++l < loads){
+		crusde_set_current_load_component(l);
+
+		RESET(x,y);
+		while(++y < N_Y){
+			x = -1;
+			while(++x < N_X){
+				load_in[x+N_XR*y] = (y < size_y && x < size_x ? crusde_get_load_at(x, y) : 0.0);
+			}
+		}
+
+		fftw_execute(load_plan);
+
+		if((load_spectra[l] = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * N_C)) == NULL){
+			crusde_bad_alloc();
+		}
+		memcpy(load_spectra[l], load_out, sizeof(fftw_complex) * N_C);
+	}
+   }
+
+   crusde_set_result(result);
+
+   return green;
+}
+
+//! Adds the convolution of the Green's function spectrum green with the weighted sum of the load spectra to out
+/** 
+ * The load spectra of transform_loads() are summed with weight[l], loads of weight 0 are skipped. 
+ * Each thread sums SUM_BLOCK spectral values of all loads at a time. The sum is multiplied with 
+ * the spectrum of each displacement dimension and transformed back in one batch, the region of 
+ * interest is added to out[dimension].
+ */
+extern void convolve_transformed(void *green, const double *weight, double **out)
+{
+   /* loop variables of the parallel loops, the global ones would be shared between threads */
+   int block, end, row, col, k, l;
+   double *real;
+
+   #pragma omp parallel for num_threads(threads) private(end, k, l)
+   for(block = 0; block < N_C; block += SUM_BLOCK){
+	end = (block + SUM_BLOCK < N_C ? block + SUM_BLOCK : N_C);
+
+	for(k = block; k < end; ++k){
+		load_out[k] = 0.0;
+	}
+
+	for(l = 0; l < spectra_loads; ++l){
+		if(weight[l] == 0.0){
+			continue;
+		}
+		for(k = block; k < end; ++k){
+			load_out[k] += weight[l] * load_spectra[l][k];
+		}
+	}
+   }
+
+   multiply((green_spectrum*) green, load_out, conv_in, threads);
+
+   fftw_execute(conv_plan);
+
+   n=-1;
+   while(++n < displacement_dimensions){   
+	real = conv_out + n*2*N_C;
+
+	#pragma omp parallel for num_threads(threads) private(col)
+	for(row = 0; row < size_y; ++row){
+		for(col = 0; col < size_x; ++col){
+			out[n][col+size_x*row] += real[col+N_XR*row];
+		}
+	}
+   }
+}
@@ -0,0 +1,759 @@
+/***************************************************************************
+ * File:        ./plugins/operator/fast_conv_tiled.c
+ * Author:      agent
+ * Created:     17.10.2026
+ * Licence:     GPL
+ ****************************************************************************/
+
+/**
+ *  @ingroup Operator
+ */
+ /*@{*/
+/** \file fast_conv_tiled.c
+ *
+ * Implements the fast 2d convolution of 'fast 2d convolution' for regions whose padded
+ * operator space does not fit into memory. The region of interest is split into tiles
+ * and the convolution is done tile by tile in the spectral domain (partitioned
+ * overlap-save): the output of tile o is the sum over all load tiles l of the load tile
+ * convolved with the part of the Green's function that connects the two tiles. The
+ * sum is formed in the spectral domain, so each output tile needs one inverse DFT only.
+ *
+ * Spectra of load tiles and Green's function blocks are kept in scratch files, only the
+ * buffers of one tile, one Green's function block and one accumulator are in memory.
+ * Their size is chosen to fit the memory budget. The result of the region of interest
+ * is handed to CrusDe as a whole, as by any other operator.
+ *
+ * With a truncated Green's function (kernel_radius) only the blocks within its support
+ * are computed and only the tile pairs they connect are multiplied.
+ */
+/*@}*/
+
+#include <complex.h>
+#include <fftw3.h>
+#include <omp.h>
+#include "crusde_api.h"
+#include "fft_tools.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+
+#define RESET(x,y) (x = y = -1)
+#define MIN(a,b) ((a) < (b) ? (a) : (b))
+#define MAX(a,b) ((a) > (b) ? (a) : (b))
+
+/*variables*/
+/* tile_in/tile_out, green_in/green_out and acc_in/acc_out share memory, the transforms are done in-place */
+/* green_out and acc_out hold one half spectrum per displacement dimension, they are transformed in one batch */
+double       *tile_in,  *green_in,  *acc_in;
+fftw_complex *tile_out, *green_out, *acc_out;
+fftw_plan     load_plan, green_plan, conv_plan;
+
+double      **result;
+double       *green_back;
+double       *green_row;		/*one row of Green's function values, all displacement dimensions interleaved*/
+boolean      *tile_is_zero;		/*load tiles without load are skipped*/
+
+/* B_X, B_Y: tile size; T_X, T_Y: number of tiles per axis */
+int B_X, B_Y, T_X, T_Y;
+/* M_X, M_Y: DFT size of a tile; M_XC: complex values per row of the half spectrum, M_XR: padded length */
+/* of a real row for in-place DFT, M_C: half spectrum size */
+int M, M_X, M_Y, M_XC, M_XR, M_C;
+int size_x, size_y;
+int x=-1, y=-1, n=-1;
+int dimensions=1;
+int displacement_dimensions=1;
+
+/* scratch files, unlinked as soon as they are created */
+int green_fd = -1;		/*spectra of the Green's function blocks*/
+int load_fd  = -1;		/*spectra of the load tiles*/
+
+/* offsets covered by the Green's function, at most size-1, and its radius in grid cells (-1: not truncated) */
+int reach_x, reach_y;
+int kernel_radius = -1;
+
+/* the Green's function the spectra in green_fd were computed for */
+char *green_plugin = NULL;
+char *green_job    = NULL;
+int   green_gridsize = 0;
+
+double *p_memory_budget;	/*memory for DFT buffers in MB*/
+char **p_scratch_dir;		/*directory for scratch files, default: $TMPDIR or /tmp*/
+char **p_fft_planner;		/*FFTW planner rigor: 'estimate' (default), 'measure' or 'patient'*/
+unsigned planner_flags = FFTW_ESTIMATE;
+double *p_threads;		/*number of threads, <= 0: all available cores*/
+int threads = 1;
+double *p_kernel_radius;	/*radius of the Green's function support in m, 0: not truncated*/
+double *p_kernel_tolerance;	/*relative tolerance the kernel radius is chosen from if kernel_radius is 0, 0: off*/
+
+boolean is_initialized = false;
+
+/* plugin interface */
+extern void register_output_fields();
+extern void register_parameter();
+extern void request_plugins();
+extern void init();
+extern void clear();
+extern void run();
+
+extern const char* get_name() 	 { return "tiled 2d convolution"; }
+extern const char* get_version() { return "0.1"; }
+extern const char* get_authors() { return "agent"; }
+extern const char* get_description() { return "Performs the fast 2D-convolution of 'fast 2d convolution' tile by tile \
+    for regions too large for memory, based on FFTW3 (http://www.fftw.org). Spectra of load tiles and \
+    Green's function blocks are kept in scratch files, the tile size is chosen to fit memory_budget. \
+    <br /><br /> \
+    NOTE: This plug-in will treat only one load function.";
+}
+extern PluginCategory get_category() { return KERNEL_PLUGIN; }
+/*!empty*/
+extern void request_plugins(){}
+/*!empty*/
+extern void register_output_fields(){}
+
+/******************************************************************/
+/***IMPLEMENTATION*************************************************/
+/******************************************************************/
+
+//! Register parameters this Kernel claims from the input.
+/*! This plugin calls register_kernel_param() defined in crusde_api.h to register
+ *  references to parameters this Kernel will need to operate properly.
+ *  For command line use the order of registration in this function defines the
+ *  identification of parameters in the command line string (i.e. './green -KfirstRegistered/secondRegistered/...').
+ *  In case an XML is used to configure the experiment, the reference to this parameter will be identified by
+ *  the string passed as second argument to register_kernel_param().
+ *
+ *  This function registers the references in the following order:
+ *	-# memory_budget	(optional, memory for the DFT buffers in MB, default: 512)
+ *	-# scratch_dir	(optional, directory for scratch files, default: $TMPDIR or /tmp)
+ *	-# fft_planner	(optional, 'estimate', 'measure' or 'patient', default: 'estimate')
+ *	-# threads	(optional, default: 0, i.e. number of available cores)
+ *	-# kernel_radius	(optional, support of the Green's function in m, default: 0, i.e. not truncated)
+ *	-# kernel_tolerance	(optional, relative tolerance for an automatic kernel_radius, default: 0, i.e. off)
+ *
+ *  Thus, the command line parameter string is: <tt>-K</tt>
+ *
+ *  @see register_kernel_param()
+ *  @see register_parameter() (temp_plugin.c.tmp)
+ */
+extern void register_parameter(){
+   /* tell main program about parameters we claim from input */
+   p_memory_budget = crusde_register_optional_param_double("memory_budget", get_category(), 512.0);
+   p_scratch_dir   = crusde_register_optional_param_string("scratch_dir", get_category(), "");
+   p_fft_planner   = crusde_register_optional_param_string("fft_planner", get_category(), "estimate");
+   p_threads       = crusde_register_optional_param_double("threads", get_category(), 0.0);
+   p_kernel_radius    = crusde_register_optional_param_double("kernel_radius", get_category(), 0.0);
+   p_kernel_tolerance = crusde_register_optional_param_double("kernel_tolerance", get_category(), 0.0);
+}
+
+/*! bytes of the in-memory buffers for the current tile and DFT sizes*/
+static double working_set()
+{
+   return (double) sizeof(fftw_complex) * M_Y * (M_X/2+1) * (1 + 2*displacement_dimensions) +
+          (double) sizeof(double) * (2*size_x-1) * displacement_dimensions;
+}
+
+//! Chooses the largest tiles whose buffers fit the memory budget
+/**
+ * A tile of B values needs a DFT of at least 2*B-1 values: the Green's function block that
+ * connects two tiles spans 2*B-1 offsets and the wrap around of the cyclic convolution
+ * only affects output values that are discarded (overlap-save).
+ */
+static void choose_tiles()
+{
+   double budget = *p_memory_budget * 1024.0 * 1024.0;
+   int b = MAX(size_x, size_y);
+
+   while(true){
+	B_X = MIN(b, size_x);
+	B_Y = MIN(b, size_y);
+	M_X = fft_smooth_size(2*B_X-1);
+	M_Y = fft_smooth_size(2*B_Y-1);
+
+	if(working_set() <= budget || b == 1){
+		break;
+	}
+
+	b = MIN(b-1, (b*9)/10);
+   }
+
+   /* the DFT size is rounded up anyway, use all of it */
+   B_X = MIN((M_X+1)/2, size_x);
+   B_Y = MIN((M_Y+1)/2, size_y);
+
+   T_X = (size_x + B_X - 1) / B_X;
+   T_Y = (size_y + B_Y - 1) / B_Y;
+
+   if(working_set() > budget){
+	crusde_warning("(%s) memory_budget of %g MB is too small, using %.1f MB", get_name(), *p_memory_budget, working_set()/1024.0/1024.0);
+   }
+}
+
+//! Creates a scratch file in the scratch directory, it is unlinked right away and vanishes when closed
+static int open_scratch(const char *what)
+{
+   char path[FILENAME_MAX];
+   const char *dir = *p_scratch_dir;
+   int fd;
+
+   if(dir == NULL || strlen(dir) == 0){
+	dir = getenv("TMPDIR");
+   }
+   if(dir == NULL || strlen(dir) == 0){
+	dir = "/tmp";
+   }
+
+   snprintf(path, sizeof(path), "%s/crusde_%s.XXXXXX", dir, what);
+
+   if( (fd = mkstemp(path)) < 0 ){
+	crusde_error("(%s) cannot create scratch file %s: %s", get_name(), path, strerror(errno));
+   }
+
+   unlink(path);
+
+   return fd;
+}
+
+/*! writes bytes from buffer to the scratch file fd at offset*/
+static void scratch_write(int fd, const void *buffer, size_t bytes, off_t offset)
+{
+   const char *p = (const char*) buffer;
+   ssize_t done;
+
+   while(bytes > 0){
+	if( (done = pwrite(fd, p, bytes, offset)) < 0 ){
+		if(errno == EINTR) continue;
+		crusde_error("(%s) cannot write scratch file: %s", get_name(), strerror(errno));
+	}
+	p      += done;
+	offset += done;
+	bytes  -= done;
+   }
+}
+
+/*! reads bytes from the scratch file fd at offset into buffer*/
+static void scratch_read(int fd, void *buffer, size_t bytes, off_t offset)
+{
+   char *p = (char*) buffer;
+   ssize_t done;
+
+   while(bytes > 0){
+	if( (done = pread(fd, p, bytes, offset)) <= 0 ){
+		if(done < 0 && errno == EINTR) continue;
+		crusde_error("(%s) cannot read scratch file: %s", get_name(), (done < 0 ? strerror(errno) : "unexpected end of file"));
+	}
+	p      += done;
+	offset += done;
+	bytes  -= done;
+   }
+}
+
+//! Initialization of the convolution. Allocation of memory for inputs and outputs
+/**
+ * Chooses the tiling (see choose_tiles()), allocates the buffers for one load tile, one Green's
+ * function block and one accumulator, all in the padded layout of an in-place DFT, and creates
+ * the FFTW plans for them. The spectra of the Green's function blocks are computed on the first
+ * call of run() for a job.
+ */
+extern void init(){
+   int shape[2], real_shape[2], complex_shape[2];
+
+   size_x = crusde_get_size_x(); // LONGITUDE
+   size_y = crusde_get_size_y(); // LATITUDE
+
+   dimensions = crusde_get_dimensions();
+   displacement_dimensions = crusde_get_displacement_dimensions();
+
+   /* threaded FFTW plans, the element-wise loops in run() use the same number of threads */
+   threads = fft_init_threads(*p_threads);
+
+   planner_flags = fft_planner_flags(*p_fft_planner);
+   fft_import_wisdom();
+
+   choose_tiles();
+
+   M    = M_X*M_Y;
+   M_XC = M_X/2 + 1;
+   M_XR = 2*M_XC;
+   M_C  = M_Y*M_XC;
+
+   shape[0] = M_Y;	shape[1] = M_X;
+   real_shape[0] = M_Y;	real_shape[1] = M_XR;
+   complex_shape[0] = M_Y;	complex_shape[1] = M_XC;
+
+   crusde_info("(%s) %d x %d tiles of %d x %d, DFT size: %d x %d, working set: %.1f MB",
+               get_name(), T_X, T_Y, B_X, B_Y, M_X, M_Y, working_set()/1024.0/1024.0);
+
+   /* the Green's function is evaluated for all offsets between two points of the region */
+   crusde_set_operator_space(2*size_x-1, 2*size_y-1);
+
+/*------------------------------*/
+/*Allocation of Memory		*/
+/*------------------------------*/
+   tile_out  = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * M_C);
+   green_out = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * M_C * displacement_dimensions);
+   acc_out   = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * M_C * displacement_dimensions);
+
+   result       = (double**) fftw_malloc(sizeof(double*) * dimensions);
+   green_back   = (double*) fftw_malloc(sizeof(double) * displacement_dimensions);
+   green_row    = (double*) fftw_malloc(sizeof(double) * (2*size_x-1) * displacement_dimensions);
+   tile_is_zero = (boolean*) malloc(sizeof(boolean) * T_X * T_Y);
+
+   if (tile_out == NULL || green_out == NULL || acc_out == NULL || result == NULL ||
+       green_back == NULL || green_row == NULL || tile_is_zero == NULL) {
+       crusde_bad_alloc();
+   }
+
+   tile_in  = (double*) tile_out;
+   green_in = (double*) green_out;
+   acc_in   = (double*) acc_out;
+
+   n=-1;
+   while(++n < dimensions){
+	result[n] = (double*) fftw_malloc(sizeof(double) * size_x * size_y);
+
+	if (result[n] == NULL){
+		crusde_bad_alloc();
+	}
+
+	x = -1;
+	while(++x < size_x * size_y){
+		result[n][x] = 0.0;
+	}
+   }
+
+/*------------------------------*/
+/*Creation of Deformation Plans	*/
+/*------------------------------*/
+   crusde_info("(%s) planning FFT ...", get_name());
+   /* row major: M_Y rows of M_X values, i.e. value (x,y) is found at x+M_XR*y */
+   load_plan  = fftw_plan_dft_r2c_2d(M_Y, M_X, tile_in, tile_out, planner_flags);
+   green_plan = fftw_plan_many_dft_r2c(2, shape, displacement_dimensions,
+                                       green_in, real_shape, 1, 2*M_C,
+                                       green_out, complex_shape, 1, M_C, planner_flags);
+   conv_plan  = fftw_plan_many_dft_c2r(2, shape, displacement_dimensions,
+                                       acc_out, complex_shape, 1, M_C,
+                                       acc_in, real_shape, 1, 2*M_C, planner_flags);
+
+   if(planner_flags != FFTW_ESTIMATE){
+	fft_export_wisdom();
+   }
+
+   load_fd = open_scratch("load");
+
+   is_initialized = true;
+}
+
+/*! Frees memory allocated during init(). FFTW plans are destroyed, scratch files closed.*/
+extern void clear(){
+   if(is_initialized)
+   {
+	   fftw_destroy_plan(load_plan);
+	   fftw_destroy_plan(green_plan);
+	   fftw_destroy_plan(conv_plan);
+
+	   fftw_free(tile_out);
+	   fftw_free(green_out);
+	   fftw_free(acc_out);
+
+	   n=-1;
+	   while(++n < dimensions){
+		if(result[n] != NULL)
+		   	fftw_free(result[n]);
+	   }
+
+	   fftw_free(result);
+	   fftw_free(green_back);
+	   fftw_free(green_row);
+	   free(tile_is_zero);
+
+	   close(load_fd);
+	   if(green_fd >= 0){
+		close(green_fd);
+		green_fd = -1;
+	   }
+
+	   free(green_plugin);
+	   free(green_job);
+	   green_plugin = green_job = NULL;
+
+	   is_initialized = false;
+  }
+}
+
+/*! fills green_row with the Green's function at offsets (-reach_x ... reach_x, gy), mirrored from first if it is not NULL
+ *  With workspaces (one per thread, see crusde_new_green_workspace()) the offsets are evaluated by all threads, 
+ *  FFT_ROW_CHUNK offsets at a time with fft_green_row().
+ */
+static void sample_green_row(int gy, double *first, double sign[][3], void **workspace)
+{
+   /* loop variables of the parallel loops, the global ones would be shared between threads */
+   int gx, quadrant, last, d;
+
+   if(first == NULL && workspace != NULL){
+	/* largest |gx| within the kernel radius */
+	last = reach_x;
+	while(last >= 0 && kernel_radius >= 0 && last*last + gy*gy > kernel_radius*kernel_radius){
+		--last;
+	}
+
+	for(gx = 0; gx < (2*reach_x+1) * displacement_dimensions; ++gx){
+		green_row[gx] = 0.0;
+	}
+
+	/* offsets gx >= 0 forwards from the center of the row, gx < 0 backwards from it */
+	#pragma omp parallel for num_threads(threads) schedule(dynamic)
+	for(gx = 0; gx <= last; gx += FFT_ROW_CHUNK){
+		fft_green_row(workspace[omp_get_thread_num()], &green_row[(reach_x+gx)*displacement_dimensions], displacement_dimensions,
+		              gx, abs(gy), (last-gx+1 < FFT_ROW_CHUNK ? last-gx+1 : FFT_ROW_CHUNK), (gy >= 0 ? 1 : 2));
+	}
+
+	#pragma omp parallel for num_threads(threads) schedule(dynamic)
+	for(gx = 1; gx <= last; gx += FFT_ROW_CHUNK){
+		fft_green_row(workspace[omp_get_thread_num()], &green_row[(reach_x-gx)*displacement_dimensions], -displacement_dimensions,
+		              gx, abs(gy), (last-gx+1 < FFT_ROW_CHUNK ? last-gx+1 : FFT_ROW_CHUNK), (gy < 0 ? 3 : 4));
+	}
+
+	return;
+   }
+
+   for(gx = -reach_x; gx <= reach_x; ++gx){
+	if(kernel_radius >= 0 && gx*gx + gy*gy > kernel_radius*kernel_radius){
+		for(d = 0; d < displacement_dimensions; ++d){
+			green_back[d] = 0.0;
+		}
+	}
+	else{
+		quadrant = (gx >= 0 ? (gy >= 0 ? 1 : 2) : (gy < 0 ? 3 : 4));
+
+		if(first != NULL){
+			for(d = 0; d < displacement_dimensions; ++d){
+				green_back[d] = sign[quadrant][d] * first[abs(gx)*displacement_dimensions + d];
+			}
+		}
+		else{
+			crusde_set_quadrant(quadrant);
+			crusde_get_green_at(&green_back, abs(gx), abs(gy));
+		}
+	}
+
+	for(d = 0; d < displacement_dimensions; ++d){
+		green_row[(gx+reach_x)*displacement_dimensions + d] = green_back[d];
+	}
+   }
+}
+
+//! Samples the Green's function for all offsets between two points of the region it covers
+/**
+ * Offsets (gx,gy) range from -reach to reach on each axis. The Green's function is requested
+ * for the absolute offsets, the quadrant tells it the signs (as in 'fast 2d convolution'), beyond
+ * kernel_radius it is set to 0. If the Green's function declares a symmetry (see 
+ * fft_mirror_signs()), only offsets gx, gy >= 0 are requested and mirrored to the rows gy and -gy.
+ * Row gy+reach_y is written to the scratch file fd, the values of all displacement dimensions 
+ * interleaved. A reentrant Green's function (crusde_green_is_reentrant()) is evaluated by all 
+ * threads in segments along the rows (see fft_green_row()), each row is split among them.
+ */
+static void sample_green(int fd)
+{
+   size_t row_bytes = sizeof(double) * (2*reach_x+1) * displacement_dimensions;
+   double sign[5][3], *first = NULL;
+   void **workspace = NULL;
+   int gx, gy, quadrant, mirror, last;
+
+   mirror = 1;
+   quadrant = 0;
+   while(++quadrant <= 4){
+	mirror = mirror && fft_mirror_signs(quadrant, sign[quadrant]);
+   }
+
+   if(mirror){
+	first = (double*) malloc(sizeof(double) * (reach_x+1) * displacement_dimensions);
+	if(first == NULL){ crusde_bad_alloc(); }
+   }
+
+   /* workspaces are not created reentrantly */
+   if(crusde_green_is_reentrant()){
+	workspace = (void**) malloc(sizeof(void*) * threads);
+	if(workspace == NULL){ crusde_bad_alloc(); }
+
+	quadrant = -1;
+	while(++quadrant < threads){
+		workspace[quadrant] = crusde_new_green_workspace();
+	}
+   }
+
+   for(gy = 0; gy <= reach_y; ++gy){
+	if(mirror){
+		/* offsets gx >= 0 within the kernel radius */
+		last = reach_x;
+		while(last >= 0 && kernel_radius >= 0 && last*last + gy*gy > kernel_radius*kernel_radius){
+			--last;
+		}
+
+		if(workspace != NULL){
+			#pragma omp parallel for num_threads(threads) schedule(dynamic)
+			for(gx = 0; gx <= last; gx += FFT_ROW_CHUNK){
+				fft_green_row(workspace[omp_get_thread_num()], &first[gx*displacement_dimensions], displacement_dimensions,
+				              gx, gy, (last-gx+1 < FFT_ROW_CHUNK ? last-gx+1 : FFT_ROW_CHUNK), 1);
+			}
+		}
+		else{
+			crusde_set_quadrant(1);
+			for(gx = 0; gx <= last; ++gx){
+				crusde_get_green_at(&green_back, gx, gy);
+
+				n=-1;
+				while(++n < displacement_dimensions){
+					first[gx*displacement_dimensions + n] = green_back[n];
+				}
+			}
+		}
+	}
+
+	sample_green_row(gy, first, sign, workspace);
+	scratch_write(fd, green_row, row_bytes, (off_t) (gy+reach_y) * row_bytes);
+
+	if(gy > 0){
+		sample_green_row(-gy, first, sign, workspace);
+		scratch_write(fd, green_row, row_bytes, (off_t) (-gy+reach_y) * row_bytes);
+	}
+   }
+
+   if(workspace != NULL){
+	quadrant = -1;
+	while(++quadrant < threads){
+		crusde_free_green_workspace(workspace[quadrant]);
+	}
+	free(workspace);
+   }
+
+   free(first);
+}
+
+/*! returns 'true' if the Green's function block for tile offset (dx,dy) has offsets within reach*/
+static boolean block_in_support(int dx, int dy)
+{
+   return ( abs(dx)*B_X - (B_X-1) <= reach_x && abs(dy)*B_Y - (B_Y-1) <= reach_y );
+}
+
+//! Computes the spectra of all Green's function blocks for the current job
+/**
+ * The block for tile offset (dx,dy) holds the Green's function at offsets dx*B_X-(B_X-1) ...
+ * dx*B_X+(B_X-1) (same for y) at positions 0 ... 2*B_X-2 of the DFT buffer. Offsets beyond
+ * reach are set to 0, they connect no two points of the region or are outside the support of a
+ * truncated Green's function. Spectra are scaled by 1/M and written to green_fd, block 
+ * (dx+T_X-1) + (2*T_X-1)*(dy+T_Y-1). Blocks without offsets within reach are skipped.
+ */
+static void compute_green_spectra()
+{
+   size_t row_bytes;
+   size_t block_bytes = sizeof(fftw_complex) * M_C * displacement_dimensions;
+   int sample_fd;
+   int dx, dy, mx, my, mx_lo, mx_hi, gy, k, blocks = 0;
+
+   /* offsets the Green's function covers */
+   kernel_radius = fft_kernel_radius(*p_kernel_radius, *p_kernel_tolerance,
+                                     (int) ceil(sqrt((double) (size_x-1)*(size_x-1) + (double) (size_y-1)*(size_y-1))));
+   reach_x = (kernel_radius >= 0 && kernel_radius < size_x-1 ? kernel_radius : size_x-1);
+   reach_y = (kernel_radius >= 0 && kernel_radius < size_y-1 ? kernel_radius : size_y-1);
+   row_bytes = sizeof(double) * (2*reach_x+1) * displacement_dimensions;
+
+   sample_fd = open_scratch("green_samples");
+
+   crusde_info("(%s) sampling Green's function for job '%s' ...", get_name(), green_job);
+   sample_green(sample_fd);
+
+   if(green_fd >= 0){
+	close(green_fd);
+   }
+   green_fd = open_scratch("green");
+
+   crusde_info("(%s) computing spectra of Green's function blocks ...", get_name());
+
+   for(dy = -(T_Y-1); dy <= T_Y-1; ++dy){
+	for(dx = -(T_X-1); dx <= T_X-1; ++dx){
+		if(!block_in_support(dx, dy)){
+			continue;
+		}
+
+		memset(green_in, 0, block_bytes);
+
+		/* range of positions in the block whose x offset is within reach */
+		mx_lo = MAX(0,       -reach_x - dx*B_X + (B_X-1));
+		mx_hi = MIN(2*B_X-2,  reach_x - dx*B_X + (B_X-1));
+
+		for(my = 0; my <= 2*B_Y-2; ++my){
+			gy = dy*B_Y + my - (B_Y-1);
+			if(gy < -reach_y || gy > reach_y){
+				continue;
+			}
+
+			scratch_read(sample_fd, green_row, sizeof(double) * (mx_hi-mx_lo+1) * displacement_dimensions,
+			             (off_t) (gy+reach_y) * row_bytes +
+			             sizeof(double) * (dx*B_X + mx_lo - (B_X-1) + reach_x) * displacement_dimensions);
+
+			for(mx = mx_lo; mx <= mx_hi; ++mx){
+				n=-1;
+				while(++n < displacement_dimensions){
+					green_in[n*2*M_C + mx + M_XR*my] = green_row[(mx-mx_lo)*displacement_dimensions + n];
+				}
+			}
+		}
+
+		/* all components in one batch, scaled by 1/M once, the inverse DFT of FFTW is unnormalized */
+		fftw_execute(green_plan);
+
+		#pragma omp parallel for num_threads(threads)
+		for(k = 0; k < M_C * displacement_dimensions; ++k){
+			green_out[k] /= M;
+		}
+
+		scratch_write(green_fd, green_out, block_bytes,
+		              (off_t) ((dx+T_X-1) + (2*T_X-1)*(dy+T_Y-1)) * block_bytes);
+		++blocks;
+	}
+   }
+
+   crusde_info("(%s) %d of %d Green's function blocks within reach", get_name(), blocks, (2*T_X-1)*(2*T_Y-1));
+
+   /* the samples are not needed anymore, closing frees the disk space */
+   close(sample_fd);
+}
+
+//! Makes sure the Green's function spectra in green_fd belong to the current job
+static void update_green_spectra()
+{
+   const char *plugin = crusde_get_current_green_plugin();
+   const char *job    = crusde_get_current_job();
+   int gridsize       = crusde_get_gridsize();
+
+   if( green_fd >= 0 && gridsize == green_gridsize &&
+       strcmp(plugin, green_plugin) == 0 && strcmp(job, green_job) == 0 ){
+	return;
+   }
+
+   free(green_plugin);
+   free(green_job);
+
+   green_plugin = (char*) malloc(strlen(plugin)+1);
+   green_job    = (char*) malloc(strlen(job)+1);
+
+   if(green_plugin == NULL || green_job == NULL){
+	crusde_bad_alloc();
+   }
+
+   strcpy(green_plugin, plugin);
+   strcpy(green_job, job);
+   green_gridsize = gridsize;
+
+   compute_green_spectra();
+}
+
+//! Transforms all load tiles and writes their spectra to load_fd, tile tx + T_X*ty
+static void compute_load_spectra()
+{
+   size_t tile_bytes = sizeof(fftw_complex) * M_C;
+   int tx, ty, lx, ly;
+   double load;
+
+   for(ty = 0; ty < T_Y; ++ty){
+	for(tx = 0; tx < T_X; ++tx){
+		memset(tile_in, 0, tile_bytes);
+		tile_is_zero[tx + T_X*ty] = true;
+
+		/* the load function is not thread safe */
+		for(ly = 0; ly < B_Y && ty*B_Y+ly < size_y; ++ly){
+			for(lx = 0; lx < B_X && tx*B_X+lx < size_x; ++lx){
+				load = crusde_get_load_at(tx*B_X+lx, ty*B_Y+ly);
+				tile_in[lx + M_XR*ly] = load;
+
+				if(load != 0.0){
+					tile_is_zero[tx + T_X*ty] = false;
+				}
+			}
+		}
+
+		if(!tile_is_zero[tx + T_X*ty]){
+			fftw_execute(load_plan);
+			scratch_write(load_fd, tile_out, tile_bytes, (off_t) (tx + T_X*ty) * tile_bytes);
+		}
+	}
+   }
+}
+
+//! Performs the tiled convolution
+/**
+ * Makes sure the Green's function spectra of the current job are available, transforms all
+ * load tiles, then for each output tile sums the products of the load tile spectra and the
+ * spectra of the connecting Green's function blocks. One batched inverse DFT per output tile
+ * gives the result of all displacement dimensions; values B-1 ... 2*B-2 of each axis belong
+ * to the output tile, the others are contaminated by the wrap around and discarded.
+ */
+extern void run()
+{
+   size_t tile_bytes  = sizeof(fftw_complex) * M_C;
+   size_t block_bytes = tile_bytes * displacement_dimensions;
+   fftw_complex *spectrum, *green_n;
+   double *real;
+   int ox, oy, tx, ty, row, col, k;
+
+   update_green_spectra();
+   compute_load_spectra();
+
+   crusde_info("(%s) Convolution of Green's function and load ...", get_name());
+
+   for(oy = 0; oy < T_Y; ++oy){
+	for(ox = 0; ox < T_X; ++ox){
+		memset(acc_out, 0, block_bytes);
+
+		for(ty = 0; ty < T_Y; ++ty){
+			for(tx = 0; tx < T_X; ++tx){
+				if(tile_is_zero[tx + T_X*ty] || !block_in_support(ox-tx, oy-ty)){
+					continue;
+				}
+
+				scratch_read(load_fd, tile_out, tile_bytes, (off_t) (tx + T_X*ty) * tile_bytes);
+				scratch_read(green_fd, green_out, block_bytes,
+				             (off_t) ((ox-tx+T_X-1) + (2*T_X-1)*(oy-ty+T_Y-1)) * block_bytes);
+
+				/* convolution in space domain == multiplication in frequency domain, summed over load tiles */
+				n=-1;
+				while(++n < displacement_dimensions){
+					spectrum = acc_out + n*M_C;
+					green_n  = green_out + n*M_C;
+
+					#pragma omp parallel for num_threads(threads)
+					for(k = 0; k < M_C; ++k){
+						spectrum[k] += green_n[k] * tile_out[k];
+					}
+				}
+			}
+		}
+
+		/* inverse transform of the results of all dimensions (back to space domain) */
+		fftw_execute(conv_plan);
+
+		/* extract the output tile, it starts at B-1 in both directions */
+		n=-1;
+		while(++n < displacement_dimensions){
+			real = acc_in + n*2*M_C;
+
+			#pragma omp parallel for num_threads(threads) private(col)
+			for(row = 0; row < B_Y; ++row){
+				for(col = 0; col < B_X; ++col){
+					if(oy*B_Y+row < size_y && ox*B_X+col < size_x){
+						result[n][(ox*B_X+col) + size_x*(oy*B_Y+row)] = real[(col+B_X-1) + M_XR*(row+B_Y-1)];
+					}
+				}
+			}
+		}
+	}
+   }
+
+   /* give result to main application */
+   crusde_set_result(result);
+}
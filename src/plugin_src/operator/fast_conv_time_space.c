@@ -25,17 +25,48 @@
 #include <stdio.h>
 #include <time.h>
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fft_tools.h"
 
 
 #define RESET(x,y) (x = y = -1)
 #define POSITION(m,n) (n+(N_Y)*m)
 
+/**
+ * Response to one load of one job: the spatial convolution of the load with the Green's 
+ * function and the series of its temporal weights, i.e. the convolution of crustal decay 
+ * and load history. The displacement at model time t is the sum of weight[t] times the 
+ * field over the responses to all loads of all jobs run so far.
+ */
+typedef struct s_load_response
+{
+	double **field;				/*spatial response of each displacement dimension, size_X*size_Y values*/
+	double  *weight;			/*temporal weights, size_T values*/
+	struct s_load_response *next;		/*response to the next load*/
+} load_response;
+
+/**
+ * Response to all loads of one job, superposed in the spectral domain: the spectra of the loads,
+ * weighted by their temporal weights at model time t, are summed and convolved with the Green's 
+ * function spectrum of the job in one inverse DFT (see convolve_transformed() in fast_conv.c).
+ */
+typedef struct s_spectral_response
+{
+	void    *green;				/*Green's function spectrum of the job, from transform_loads()*/
+	double  *weight;			/*temporal weights, load l at model time t is weight[l+loads*t]*/
+	int      loads;				/*number of loads*/
+	struct s_spectral_response *next;	/*response of the next job*/
+} spectral_response;
+
 /*variables*/
 double		   *decay_in,  *history_in,  *conv_out, **spatial_result;
 fftw_complex   *decay_out, *history_out, *conv_in;
 fftw_plan      decay_plan, history_plan, conv_plan;
 
-double 		   **result;
+/* responses in the order of jobs and loads, last_response is the end of the list */
+load_response *responses = NULL, *last_response = NULL;
+spectral_response *spectral_responses = NULL, *last_spectral = NULL;
 
 /* N_T: number of rows*/
 int N_T;
@@ -46,10 +77,24 @@ unsigned long int t=0;
 int dimensions=1;
 int displacement_dimensions=1;
 
+char **p_fft_size;		/*choice of DFT length: 'smooth' (default) or 'auto' (benchmark candidates)*/
+char **p_fft_planner;		/*FFTW planner rigor: 'estimate' (default), 'measure' or 'patient'*/
+unsigned planner_flags = FFTW_ESTIMATE;
+double *p_threads;		/*number of threads, <= 0: all available cores*/
+int threads = 1;
+char **p_load_mode;		/*'serial' (default): the loads one after another, 'parallel': batches of loads, one per thread*/
+boolean parallel_loads = false;
+char **p_superposition;		/*'auto' (default): the cheaper of 'fields' (spatial responses) and 'spectra' (spectral domain)*/
+
 boolean is_initialized = false;
 
 /* function pointer to run function of included kernel plug-in */
 void (*fast_spatial_conv) () = NULL;
+/* its batch interface, convolves all loads at once, NULL if it has none */
+boolean (*convolve_loads) (int, double***) = NULL;
+/* its interface for the superposition in the spectral domain, NULL if it has none */
+void* (*transform_loads) (int) = NULL;
+void  (*convolve_transformed) (void*, const double*, double**) = NULL;
 
 /* plugin interface */
 extern void register_output_fields();
@@ -70,6 +115,9 @@ extern PluginCategory get_category() { return KERNEL_PLUGIN; }
 extern void request_plugins()
 {
 	fast_spatial_conv = crusde_request_kernel_plugin("fast 2d convolution");
+	convolve_loads = (boolean (*) (int, double***)) crusde_request_kernel_function("fast 2d convolution", "convolve_loads");
+	transform_loads = (void* (*) (int)) crusde_request_kernel_function("fast 2d convolution", "transform_loads");
+	convolve_transformed = (void (*) (void*, const double*, double**)) crusde_request_kernel_function("fast 2d convolution", "convolve_transformed");
 }
 /*!empty*/
 extern void register_output_fields(){}
@@ -87,6 +135,11 @@ extern void register_output_fields(){}
  *  the string passed as second argument to register_kernel_param().
  *
  *  This function registers the references in the following order:
+ *	-# fft_size	(optional, 'smooth' or 'auto', default: 'smooth', shared with 'fast 2d convolution')
+ *	-# fft_planner	(optional, 'estimate', 'measure' or 'patient', default: 'estimate', shared with 'fast 2d convolution')
+ *	-# threads	(optional, default: 0, i.e. number of available cores, shared with 'fast 2d convolution')
+ *	-# load_mode	(optional, 'serial' or 'parallel', default: 'serial')
+ *	-# superposition	(optional, 'auto', 'fields' or 'spectra', default: 'auto')
  *
  *  Thus, the command line parameter string is: <tt>-K</tt>
  *
@@ -95,16 +148,24 @@ extern void register_output_fields(){}
  */
 extern void register_parameter(){
    /* tell main program about parameters we claim from input */
+   p_fft_size = crusde_register_optional_param_string("fft_size", get_category(), "smooth");
+   p_fft_planner = crusde_register_optional_param_string("fft_planner", get_category(), "estimate");
+   p_threads     = crusde_register_optional_param_double("threads", get_category(), 0.0);
+   p_load_mode   = crusde_register_optional_param_string("load_mode", get_category(), "serial");
+   p_superposition = crusde_register_optional_param_string("superposition", get_category(), "auto");
 }
 
 //! Initialization of the convolution. Allocation of memory for inputs and outputs
 /**
  * The field sizes are adjusted according to the needs to avoid wrap around
- * effects in the spectal domain and allow for effective use of DFT (lenght and 
- * width are a power of 2). Memory is allocated using fftw_malloc for DFT inputs
- * and outputs (load_in, load_out, green_in, green_out, conv_in, conv_out).
+ * effects in the spectal domain and allow for effective use of DFT (the time axis 
+ * is padded to at least 2*size_T-1 values, rounded up to a length that factors into 
+ * 2, 3, 5 and 7, or benchmarked if fft_size = 'auto'). Memory is allocated using fftw_malloc for DFT inputs
+ * and outputs (decay_in, decay_out, history_in, history_out, conv_in, conv_out). The 
+ * responses to the loads are added by run(), there is no space-time cube of results.
  * Three FFTW plans are created for DFT transform of Green and load arrays and
- * IDFT of the convolution result back to original domain.
+ * IDFT of the convolution result back to original domain. The planner rigor is set 
+ * by fft_planner; wisdom is read from and merged into the store in $CRUSDE_HOME/cache.
  */
 extern void init(){
 /*------------------------------*/
@@ -113,11 +174,39 @@ extern void init(){
    size_X = crusde_get_size_x();	//Longitude
    size_Y = crusde_get_size_y();	//latitude
    size_T = crusde_get_timesteps();
-   N_T    = 2*size_T;
 
-   /* find power of 2 that is closest to N_* and greater than or equal to N_* */ 
-   while(N_T>pow(2,i)){++i;}
-   N_T = pow(2,i);
+   /* the element-wise loops in run() are parallel, the temporal DFT is too short to gain from threads */
+   threads = fft_init_threads(*p_threads);
+   fftw_plan_with_nthreads(1);
+
+   /* plans of higher rigor profit from, and add to the wisdom of earlier runs */
+   planner_flags = fft_planner_flags(*p_fft_planner);
+   fft_import_wisdom();
+
+   /* a linear convolution of two series of length size_T needs at least 2*size_T-1 values */
+   if(strcmp(*p_fft_size, "auto") == 0){
+	N_T = fft_tune_size_1d(2*size_T-1, planner_flags);
+   }
+   else{
+	if(strcmp(*p_fft_size, "smooth") != 0){
+		crusde_error("(%s) unknown value for parameter fft_size: '%s' (use 'smooth' or 'auto')", get_name(), *p_fft_size);
+	}
+	N_T = fft_smooth_size(2*size_T-1);
+   }
+
+   if(strcmp(*p_load_mode, "serial") == 0){
+	parallel_loads = false;
+   }
+   else if(strcmp(*p_load_mode, "parallel") == 0){
+	parallel_loads = true;
+   }
+   else{
+	crusde_error("(%s) unknown value for parameter load_mode: '%s' (use 'serial' or 'parallel')", get_name(), *p_load_mode);
+   }
+
+   if(strcmp(*p_superposition, "auto") != 0 && strcmp(*p_superposition, "fields") != 0 && strcmp(*p_superposition, "spectra") != 0){
+	crusde_error("(%s) unknown value for parameter superposition: '%s' (use 'auto', 'fields' or 'spectra')", get_name(), *p_superposition);
+   }
 
    dimensions = crusde_get_dimensions();
    displacement_dimensions = crusde_get_displacement_dimensions();
@@ -134,22 +223,14 @@ extern void init(){
    conv_in  = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * N_T); // (floor(N/2)+1));
    conv_out = (double*) fftw_malloc(sizeof(double) * N_T);
 
-   result       = (double**) fftw_malloc(sizeof(double) * dimensions);
-
-   if (decay_in == NULL || decay_out == NULL || history_in == NULL || history_out == NULL || conv_in == NULL || conv_out == NULL || result == NULL) {
+   if (decay_in == NULL || decay_out == NULL || history_in == NULL || history_out == NULL || conv_in == NULL || conv_out == NULL) {
 	crusde_bad_alloc();
    }
-   
-   n=-1;
-   while(++n < dimensions){
-		if ((result[n] = (double*) fftw_malloc(sizeof(double) * size_X * size_Y * size_T)) == NULL){
-			crusde_bad_alloc();
-		}
-		x=-1;
-		while(++x < size_X * size_Y * size_T){
-			result[n][x] = 0.0;
-		}
-   }
+
+   responses     = NULL;
+   last_response = NULL;
+   spectral_responses = NULL;
+   last_spectral      = NULL;
 
       
 /*------------------------------*/
@@ -157,9 +238,13 @@ extern void init(){
 /*------------------------------*/
    /* fftw_plan_dft_r2c_1d is always FFTW_FORWARD, 		*/
    /* fftw_plan_dft_c2r_1d is always FFTW_BACKWARD 		*/ 
-   decay_plan =  fftw_plan_dft_r2c_1d(N_T, decay_in, decay_out, FFTW_ESTIMATE);
-   history_plan= fftw_plan_dft_r2c_1d(N_T, history_in, history_out, FFTW_ESTIMATE);
-   conv_plan =   fftw_plan_dft_c2r_1d(N_T, conv_in, conv_out, FFTW_ESTIMATE);
+   decay_plan =  fftw_plan_dft_r2c_1d(N_T, decay_in, decay_out, planner_flags);
+   history_plan= fftw_plan_dft_r2c_1d(N_T, history_in, history_out, planner_flags);
+   conv_plan =   fftw_plan_dft_c2r_1d(N_T, conv_in, conv_out, planner_flags);
+
+   if(planner_flags != FFTW_ESTIMATE){
+	fft_export_wisdom();
+   }
 
    /*convolution is now initialized*/   
    is_initialized = true;
@@ -181,18 +266,129 @@ extern void clear(){
 	   fftw_free(conv_in);
 	   fftw_free(conv_out);
 
-	   n=-1;
-	   while(++n < dimensions){ 
-		if(result[n] != NULL)
-		   	fftw_free(result[n]); 
+	   while(responses != NULL){
+		last_response = responses;
+		responses = responses->next;
+
+		n=-1;
+		while(++n < displacement_dimensions){
+			fftw_free(last_response->field[n]);
+		}
+		free(last_response->field);
+		fftw_free(last_response->weight);
+		free(last_response);
+	   }
+	   last_response = NULL;
+
+	   while(spectral_responses != NULL){
+		last_spectral = spectral_responses;
+		spectral_responses = spectral_responses->next;
+
+		fftw_free(last_spectral->weight);
+		free(last_spectral);
 	   }
-		   
-	   fftw_free(result);
+	   last_spectral = NULL;
 
            is_initialized = false;
    }
 }
 
+//! Appends a response to the list, its fields and weights are filled by the caller
+static load_response* new_response()
+{
+   load_response *response = (load_response*) malloc(sizeof(load_response));
+   int d;
+
+   if(response == NULL){
+	crusde_bad_alloc();
+   }
+
+   response->field  = (double**) malloc(sizeof(double*) * displacement_dimensions);
+   response->weight = (double*) fftw_malloc(sizeof(double) * size_T);
+   response->next   = NULL;
+
+   if(response->field == NULL || response->weight == NULL){
+	crusde_bad_alloc();
+   }
+
+   d=-1;
+   while(++d < displacement_dimensions){
+	if((response->field[d] = (double*) fftw_malloc(sizeof(double) * size_X * size_Y)) == NULL){
+		crusde_bad_alloc();
+	}
+   }
+
+   if(last_response == NULL){
+	responses = response;
+   }
+   else{
+	last_response->next = response;
+   }
+   last_response = response;
+
+   return response;
+}
+
+//! Appends a spectral response to the list, the caller fills its weights
+static spectral_response* new_spectral_response(void *green, int loads)
+{
+   spectral_response *response = (spectral_response*) malloc(sizeof(spectral_response));
+
+   if(response == NULL){
+	crusde_bad_alloc();
+   }
+
+   response->green  = green;
+   response->loads  = loads;
+   response->weight = (double*) fftw_malloc(sizeof(double) * loads * size_T);
+   response->next   = NULL;
+
+   if(response->weight == NULL){
+	crusde_bad_alloc();
+   }
+
+   if(last_spectral == NULL){
+	spectral_responses = response;
+   }
+   else{
+	last_spectral->next = response;
+   }
+   last_spectral = response;
+
+   return response;
+}
+
+//! Returns 'true' if superposing the loads in the spectral domain is estimated to be cheaper
+/** 
+ * Both ways transform each load once. Superposing spatial responses adds the inverse DFTs of 
+ * all loads and all displacement dimensions, and the weighted sum of loads*dimensions fields of 
+ * size_X*size_Y values per timestep. Superposing in the spectral domain adds, per timestep, the 
+ * weighted sum of the load spectra (N_X*N_Y/2 complex values each), the product with the Green's 
+ * function spectra and the inverse DFTs of all dimensions. A real DFT of N values is taken as 
+ * 2.5 N log2(N) flops. The operator space is that of 'fast 2d convolution', or estimated as 
+ * twice the region along each axis if it was not set up yet.
+ */
+static boolean spectra_are_cheaper(int loads)
+{
+   int n_x = 0, n_y = 0;
+   double dft, fields, spectra;
+
+   crusde_get_operator_space(&n_x, &n_y);
+   if(n_x <= 0 || n_y <= 0){
+	n_x = 2*size_X;
+	n_y = 2*size_Y;
+   }
+
+   dft     = 2.5 * n_x * n_y * log((double) n_x * n_y) / log(2.0);
+   fields  = loads * displacement_dimensions * (dft + 2.0 * size_T * size_X * size_Y);
+   spectra = size_T * (2.0 * loads * n_x * n_y + displacement_dimensions * (dft + 3.0 * n_x * n_y + size_X * size_Y));
+
+   crusde_info("(%s) superposition of %d loads over %d timesteps: fields %.3g flops, spectra %.3g flops", 
+               get_name(), loads, size_T, fields, spectra);
+
+   return spectra < fields;
+}
+
 //! Performs the fast convolution
 /** 
  * Requests values for each point in the examined area from Green's function (only once when modeltime == 0) 
@@ -205,11 +401,29 @@ extern void clear(){
  * is executed (IDFT). The result of the convolution is extracted from the oversized IDFT result and 
  * cropped to the original size of the examined region.
  *
- * ATTN: result[d][x] still holds the values from the last time run was called. This way adding up the results
+ * At model time 0 the spatial response to each load and its temporal weights are stored (see 
+ * new_response()). With load_mode = 'parallel' the spatial responses to all loads are computed 
+ * by 'fast 2d convolution' at once, in batches of one load per thread (see convolve_loads() in 
+ * fast_conv.c), unless it runs in single precision. 
+ *
+ * With superposition = 'spectra', or 'auto' if it is estimated to be cheaper (see 
+ * spectra_are_cheaper()), the loads are transformed once instead and only their temporal 
+ * weights are stored; the loads are summed in the spectral domain and transformed back once 
+ * per timestep (see new_spectral_response()). On every call the result for the current model time is built from them as 
+ * a weighted sum, field by field in contiguous memory; memory grows with the number of loads,
+ * not with the number of timesteps.
+ *
+ * ATTN: the responses of the jobs run before are kept and summed, too. This way adding up the results
  * of multiple jobs is realized!
  */
 extern void run()
 {   
+   /* loop variables of the parallel loops, the global ones would be shared between threads */
+   int p;
+   load_response *response;
+   double weight, *field, ***fields;
+   boolean batched = false;
+   spectral_response *spectral;
 
    RESET(x,y);
 
@@ -234,17 +448,77 @@ extern void run()
   if(crusde_model_time() == 0){
 
     int num_loads = crusde_get_number_of_loads();
+    load_response *first_response = NULL;
+    void *green = NULL;
+
+    spectral = NULL;
+
+    /* superposition in the spectral domain: transform the loads, keep their weights */
+    if( strcmp(*p_superposition, "spectra") == 0 || 
+        (strcmp(*p_superposition, "auto") == 0 && spectra_are_cheaper(num_loads)) )
+	{
+		if(transform_loads != NULL && convolve_transformed != NULL){
+			green = transform_loads(num_loads);
+		}
+
+		if(green != NULL){
+			spectral = new_spectral_response(green, num_loads);
+		}
+		else{
+			crusde_warning("(%s) 'fast 2d convolution' cannot superpose the loads in the spectral domain, superposing their responses", get_name());
+		}
+	}
+
+    /* the responses to the loads of this job, filled below */
     n = -1;
+    while(spectral == NULL && ++n < num_loads)
+	{
+		response = new_response();
+		if(n == 0) first_response = response;
+	}
+
+    /* all spatial responses at once, straight into the responses */
+    if(spectral == NULL && parallel_loads && convolve_loads != NULL)
+	{
+		fields = (double***) malloc(sizeof(double**) * num_loads);
+		if(fields == NULL){
+			crusde_bad_alloc();
+		}
+
+		for(n = 0, response = first_response; n < num_loads; ++n, response = response->next){
+			fields[n] = response->field;
+		}
+
+		batched = convolve_loads(num_loads, fields);
+		free(fields);
+	}
+
+    if(spectral == NULL && parallel_loads && !batched)
+	{
+		crusde_warning("(%s) 'fast 2d convolution' cannot convolve the loads in parallel, convolving them one by one", get_name());
+	}
+
+    n = -1;
+    response = first_response;
 
     /* iterate through loads ... */
     while(++n < num_loads)
 	{
 		/* set the load id we want to work with ...*/
         crusde_set_current_load_component(n);
-		/* invoke the spatial response */
-        fast_spatial_conv();
-		/* get a pointer to the result via crusde_get_result()*/
-        spatial_result = crusde_get_result();
+
+		if(spectral == NULL && !batched)
+		{
+			/* invoke the spatial response */
+			fast_spatial_conv();
+			/* get a pointer to the result via crusde_get_result() and keep a copy*/
+			spatial_result = crusde_get_result();
+
+			int d = -1;
+			while(++d < displacement_dimensions){
+				memcpy(response->field[d], spatial_result[d], sizeof(double) * size_X * size_Y);
+			}
+		}
 
 		/* here comes the fun part - four possibilities exist 
          * for the current load component:
@@ -347,37 +621,26 @@ extern void run()
 	        fftw_execute(conv_plan);
 		} //END CASE 4
 
-		/* conv_out now contains the values that fit the actual purpose ... and all becomes one ... */
-		t = -1;
-
-		while(++t < size_T)
+		/* conv_out now contains the values that fit the actual purpose ... keep them with the spatial response */
+		if(spectral != NULL)
+		{
+			t = -1;
+			while(++t < size_T){
+				spectral->weight[n + num_loads*t] = conv_out[t];
+			}
+		}
+		else
 		{
-//	crusde_debug("%s: conv_out[%d] = %f\n", __FILE__, t, conv_out[t]);
-                    int d = -1;
-                    while(++d < displacement_dimensions) 
-                    {
-                       y=-1;
-                       while(++y < size_Y)
-                       {	
-                          x=-1;
-                          while(++x < size_X)
-                          {	
-                             //since we live in an ideal world we can use the principle of superposition right here.
-                             result[d][t+size_T*(x+size_X*y)] += (conv_out[t] * spatial_result[d][x+size_X*y]);
-
-//crusde_debug("t=%d, d=%d, x=%d, y=%d, size_X=%d, size_Y=%d, RESULT: %f\n", t, d, x, y, size_X, size_Y, result[d][t+size_T*(y+size_Y*x)]);
-                          }
-                       }
-                    }
-                }
+			memcpy(response->weight, conv_out, sizeof(double) * size_T);
+			response = response->next;
+		}
 	}//END while loads ...
   }// end zeroth timestep
 
 
-  // now we are basically done, except that our result array is kinda goofy and
   // we follow the convention of the simulation handler being the clock, 
-  // and the data output plug-ins write on every time step, we rearrange the
-  // results on every timestep and give them to the main application.
+  // and the data output plug-ins write on every time step, so the result of
+  // this timestep is put together now and given to the main application.
   t=crusde_model_time();
  
   spatial_result = crusde_get_result();
@@ -385,15 +648,34 @@ extern void run()
   int d= -1;
   while(++d < displacement_dimensions) 
   {
-	y=-1;
-	while(++y < size_Y)
-        {	
-           x=-1;
-           while(++x < size_X)
-           {	
-              spatial_result[d][x+size_X*y] = result[d][ crusde_model_time() + size_T*(x+size_X*y) ];
-           }
-        }
+	#pragma omp parallel for num_threads(threads)
+	for(p = 0; p < size_X*size_Y; ++p)
+	{
+		spatial_result[d][p] = 0.0;
+	}
+
+	//since we live in an ideal world we can use the principle of superposition right here.
+	for(response = responses; response != NULL; response = response->next)
+	{
+		weight = response->weight[t];
+		field  = response->field[d];
+
+		if(weight == 0.0){
+			continue;
+		}
+
+		#pragma omp parallel for num_threads(threads)
+		for(p = 0; p < size_X*size_Y; ++p)
+		{
+			spatial_result[d][p] += weight * field[p];
+		}
+	}
+  }
+
+  // the responses superposed in the spectral domain, all dimensions at once
+  for(spectral = spectral_responses; spectral != NULL; spectral = spectral->next)
+  {
+	convolve_transformed(spectral->green, spectral->weight + spectral->loads*t, spatial_result);
   }
 
   /* give result to main application */
@@ -0,0 +1,486 @@
+/***************************************************************************
+ * File:        ./plugins/operator/fft_tools.c
+ * Author:      agent
+ * Created:     17.10.2026
+ * Licence:     GPL
+ ****************************************************************************/
+
+/**
+ *  @ingroup Operator
+ */
+ /*@{*/
+/** \file fft_tools.c
+ *
+ * Helper functions shared by the FFTW based operator plugins: choice of transform
+ * lengths. FFTW is fastest for lengths of the form 2^a 3^b 5^c 7^d, which are much
+ * denser than powers of two and therefore need less zero padding.
+ *
+ * FFTW wisdom (the planner's measurements) is kept in $CRUSDE_HOME/cache/fftw.wisdom,
+ * and fftwf.wisdom for single precision plans, so plans of MEASURE or PATIENT rigor 
+ * cost the planning time only once per grid. 
+ * Several CrusDe processes may share the store: writers hold an exclusive lock on 
+ * fftw.wisdom.lock, merge the wisdom on disk with their own and atomically replace the
+ * file; readers hold a shared lock.
+ */
+/*@}*/
+
+#include <complex.h>
+#include <fftw3.h>
+#include <time.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include "crusde_api.h"
+#include "fft_tools.h"
+
+/* number of candidate lengths per axis that are benchmarked in auto tune mode */
+#define TUNE_CANDIDATES 4
+/* minimum time in seconds spent on timing one candidate */
+#define TUNE_MIN_TIME 0.05
+
+/*! returns 'true' if n has no prime factors other than 2, 3, 5 and 7*/
+static boolean is_smooth(int n)
+{
+	while(n % 2 == 0) n /= 2;
+	while(n % 3 == 0) n /= 3;
+	while(n % 5 == 0) n /= 5;
+	while(n % 7 == 0) n /= 7;
+
+	return (n == 1);
+}
+
+/*! wall clock time in seconds*/
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1.0e-9 * ts.tv_nsec;
+}
+
+/*! fills candidates[] with the first smooth lengths >= n, the list always ends with the next power of 2*/
+static int get_candidates(int n, int *candidates)
+{
+	int count = 0;
+	int pow2  = 1;
+	int m     = n;
+
+	while(pow2 < n){ pow2 *= 2; }
+
+	while(count < TUNE_CANDIDATES-1 && m < pow2){
+		m = fft_smooth_size(m);
+		if(m < pow2){
+			candidates[count++] = m;
+		}
+		++m;
+	}
+
+	candidates[count++] = pow2;
+
+	return count;
+}
+
+/*! times a forward and backward in-place transform of size n_x*n_y (n_y==1: 1D), returns seconds per pair*/
+static double time_transform(int n_x, int n_y, unsigned flags)
+{
+	int n_xr = 2*(n_x/2+1);
+	int i    = -1;
+	int reps = 0;
+	double start, elapsed;
+
+	double *buffer = (double*) fftw_malloc(sizeof(double) * n_xr * n_y);
+	fftw_plan forward, backward;
+
+	if(buffer == NULL){ crusde_bad_alloc(); }
+
+	if(n_y == 1){
+		forward  = fftw_plan_dft_r2c_1d(n_x, buffer, (fftw_complex*) buffer, flags);
+		backward = fftw_plan_dft_c2r_1d(n_x, (fftw_complex*) buffer, buffer, flags);
+	}
+	else{
+		forward  = fftw_plan_dft_r2c_2d(n_y, n_x, buffer, (fftw_complex*) buffer, flags);
+		backward = fftw_plan_dft_c2r_2d(n_y, n_x, (fftw_complex*) buffer, buffer, flags);
+	}
+
+	/* planning with FFTW_MEASURE or more overwrites the buffer, fill it afterwards */
+	while(++i < n_xr * n_y){
+		buffer[i] = 1.0 / (1 + i % 7);
+	}
+
+	/*warm up*/
+	fftw_execute(forward);
+	fftw_execute(backward);
+
+	start = now();
+	do{
+		fftw_execute(forward);
+		fftw_execute(backward);
+		++reps;
+		elapsed = now() - start;
+	}while(elapsed < TUNE_MIN_TIME && reps < 1000);
+
+	fftw_destroy_plan(forward);
+	fftw_destroy_plan(backward);
+	fftw_free(buffer);
+
+	return elapsed / reps;
+}
+
+//! Smallest transform length that is >= n and a product of powers of 2, 3, 5 and 7
+/*!
+ * Zero padding a region of size s to fft_smooth_size(2*s-1) avoids wrap around effects of
+ * the cyclic convolution.
+ */
+int fft_smooth_size(int n)
+{
+	if(n < 1){ return 1; }
+
+	while(!is_smooth(n)){ ++n; }
+
+	return n;
+}
+
+//! Benchmarks 1D transform lengths >= n and returns the fastest
+/*!
+ * Candidates are the first few smooth lengths >= n and the next power of 2.
+ */
+int fft_tune_size_1d(int n, unsigned flags)
+{
+	int candidates[TUNE_CANDIDATES];
+	int count = get_candidates(n, candidates);
+	int best  = candidates[0];
+	double best_time = -1.0, time;
+	int c = -1;
+
+	while(++c < count){
+		time = time_transform(candidates[c], 1, flags);
+		if(best_time < 0.0 || time < best_time){
+			best_time = time;
+			best = candidates[c];
+		}
+	}
+
+	crusde_info("(fft tune) length %d: chose %d (%.3e s per transform pair)", n, best, best_time);
+
+	return best;
+}
+
+//! Benchmarks 2D transform sizes >= (n_x, n_y) and returns the fastest in *N_X, *N_Y
+/*!
+ * All combinations of the candidate lengths of both axes are timed for a forward and a backward
+ * in-place transform, i.e. the way the operators use them.
+ */
+void fft_tune_size_2d(int n_x, int n_y, unsigned flags, int *N_X, int *N_Y)
+{
+	int cand_x[TUNE_CANDIDATES], cand_y[TUNE_CANDIDATES];
+	int count_x = get_candidates(n_x, cand_x);
+	int count_y = get_candidates(n_y, cand_y);
+	double best_time = -1.0, time;
+	int cx = -1, cy;
+
+	*N_X = cand_x[0];
+	*N_Y = cand_y[0];
+
+	while(++cx < count_x){
+		cy = -1;
+		while(++cy < count_y){
+			time = time_transform(cand_x[cx], cand_y[cy], flags);
+			if(best_time < 0.0 || time < best_time){
+				best_time = time;
+				*N_X = cand_x[cx];
+				*N_Y = cand_y[cy];
+			}
+		}
+	}
+
+	crusde_info("(fft tune) size %dx%d: chose %dx%d (%.3e s per transform pair)", n_x, n_y, *N_X, *N_Y, best_time);
+}
+
+//! Number of threads for the FFT operators, prepares FFTW for threaded plans
+/*!
+ * A requested number <= 0 means all available cores. Plans created after this call use 
+ * the returned number of threads, the operators pass the same number to their OpenMP loops.
+ */
+int fft_init_threads(double requested)
+{
+	static boolean initialized = false;
+	int threads = (int) requested;
+
+	if(threads <= 0){
+		threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if(threads < 1){
+		threads = 1;
+	}
+
+	if(!initialized){
+		if(!fftw_init_threads() || !fftwf_init_threads()){
+			crusde_warning("(fft threads) could not initialize FFTW threads, using 1 thread");
+			return 1;
+		}
+		initialized = true;
+	}
+
+	fftw_plan_with_nthreads(threads);
+	fftwf_plan_with_nthreads(threads);
+	crusde_info("(fft threads) using %d thread(s)", threads);
+
+	return threads;
+}
+
+//! Radius of the support of the Green's function in grid cells, -1 if it is not truncated
+/*!
+ * With radius > 0 the given radius in meters is used. Otherwise, if tolerance > 0, the radius
+ * is the smallest one for which the truncated part of the Green's function of the current
+ * job stays below tolerance times its total. For this the Green's function is sampled along
+ * the x axis, r = 0 ... max_offset grid cells, and |G(r)| is weighted with the circumference
+ * of the ring at r, i.e. a radially symmetric decay is assumed, as for the Green's functions
+ * in plugins/green. Each displacement dimension is checked, the largest radius is used.
+ *
+ * -1 is returned if radius and tolerance are both 0 or the radius reaches max_offset, the
+ * largest distance between two points of the region.
+ */
+int fft_kernel_radius(double radius, double tolerance, int max_offset)
+{
+	int displacement_dimensions = crusde_get_displacement_dimensions();
+	int gridsize = crusde_get_gridsize();
+	double *profile, *green, total, tail;
+	int r, n, r_n, result = 0;
+
+	if(radius > 0.0){
+		result = (int) ceil(radius / gridsize);
+		return (result >= max_offset ? -1 : result);
+	}
+
+	if(tolerance <= 0.0){
+		return -1;
+	}
+
+	profile = (double*) malloc(sizeof(double) * (max_offset+1) * displacement_dimensions);
+	green   = (double*) malloc(sizeof(double) * displacement_dimensions);
+
+	if(profile == NULL || green == NULL){ crusde_bad_alloc(); }
+
+	crusde_set_quadrant(1);
+	for(r = 0; r <= max_offset; ++r){
+		crusde_get_green_at(&green, r, 0);
+		for(n = 0; n < displacement_dimensions; ++n){
+			profile[r*displacement_dimensions + n] = fabs(green[n]) * (r == 0 ? 1.0 : 2.0*M_PI*r);
+		}
+	}
+
+	for(n = 0; n < displacement_dimensions; ++n){
+		total = 0.0;
+		for(r = 0; r <= max_offset; ++r){
+			total += profile[r*displacement_dimensions + n];
+		}
+
+		/* shrink the radius as long as the part beyond it stays within the tolerance */
+		tail = 0.0;
+		r_n  = max_offset;
+		while(r_n > 0 && tail + profile[r_n*displacement_dimensions + n] <= tolerance * total){
+			tail += profile[r_n*displacement_dimensions + n];
+			--r_n;
+		}
+
+		if(r_n > result){ result = r_n; }
+	}
+
+	free(profile);
+	free(green);
+
+	crusde_info("(fft kernel) relative tolerance %g: kernel radius %d grid cells (%d m)", tolerance, result, result*gridsize);
+
+	return (result >= max_offset ? -1 : result);
+}
+
+//! Signs that turn first quadrant values of the Green's function into those of another quadrant
+/*!
+ * Returns 0 if the Green's function of the current job declares no symmetry, every quadrant
+ * has to be requested from it then. Otherwise sign[n] is set for each displacement dimension n
+ * and 1 is returned: a value in quadrant q equals sign[n] times the first quadrant value at 
+ * (|x|,|y|). The sign is -1 for the x-component in quadrants 3 and 4 and for the y-component in 
+ * quadrants 2 and 3, see crusde_get_green_symmetry().
+ */
+int fft_mirror_signs(int quadrant, double *sign)
+{
+	int displacement_dimensions = crusde_get_displacement_dimensions();
+	int n;
+
+	if(crusde_get_green_symmetry() == NO_SYMMETRY){
+		return 0;
+	}
+
+	for(n = 0; n < displacement_dimensions; ++n){
+		sign[n] = 1.0;
+		if(n == crusde_get_x_index() && (quadrant == 3 || quadrant == 4)){ sign[n] = -1.0; }
+		if(n == crusde_get_y_index() && (quadrant == 2 || quadrant == 3)){ sign[n] = -1.0; }
+	}
+
+	return 1;
+}
+
+//! Green's function values along a row, evaluated with crusde_get_green_row_at()
+/*!
+ * Evaluates the points (x+i, y), i = 0 ... n-1, in chunks of FFT_ROW_CHUNK with the given
+ * workspace (see crusde_new_green_workspace()) and writes displacement dimension d of point i 
+ * to value[i*stride + d]. A negative stride fills value backwards from the given address. 
+ * Safe to call from several threads at once, each with a workspace of its own.
+ */
+void fft_green_row(void *workspace, double *value, int stride, int x, int y, int n, int quadrant)
+{
+	int displacement_dimensions = crusde_get_displacement_dimensions();
+	double buffer[3][FFT_ROW_CHUNK];
+	double *row[3];
+	int i, k, m, d;
+
+	for(d = 0; d < 3; ++d){
+		row[d] = buffer[d];
+	}
+
+	for(k = 0; k < n; k += FFT_ROW_CHUNK){
+		m = (n-k < FFT_ROW_CHUNK ? n-k : FFT_ROW_CHUNK);
+		crusde_get_green_row_at(workspace, row, x+k, y, m, quadrant);
+
+		for(i = 0; i < m; ++i){
+			for(d = 0; d < displacement_dimensions; ++d){
+				value[(k+i)*stride + d] = buffer[d][i];
+			}
+		}
+	}
+}
+
+//! FFTW planner flags for the planner rigor 'estimate', 'measure' or 'patient'
+/*!
+ * FFTW_ESTIMATE plans are created instantly, FFTW_MEASURE and FFTW_PATIENT plans time
+ * candidate algorithms and are faster to execute. Their planning time is saved in the
+ * wisdom store, see fft_export_wisdom().
+ */
+unsigned fft_planner_flags(const char *rigor)
+{
+	if(strcmp(rigor, "estimate") == 0) return FFTW_ESTIMATE;
+	if(strcmp(rigor, "measure")  == 0) return FFTW_MEASURE;
+	if(strcmp(rigor, "patient")  == 0) return FFTW_PATIENT;
+
+	crusde_error("unknown FFT planner rigor: '%s' (use 'estimate', 'measure' or 'patient')", rigor);
+	return FFTW_ESTIMATE;
+}
+
+/*! writes the path of $CRUSDE_HOME/cache/<name> to path, creates the cache directory if necessary*/
+static boolean cache_path(char *path, size_t length, const char *name)
+{
+	const char *home = getenv("CRUSDE_HOME");
+
+	if(home == NULL){ return false; }
+
+	snprintf(path, length, "%s/cache", home);
+	if(mkdir(path, 0755) != 0 && errno != EEXIST){
+		crusde_warning("(fft wisdom) cannot create directory %s: %s", path, strerror(errno));
+		return false;
+	}
+
+	snprintf(path, length, "%s/cache/%s", home, name);
+	return true;
+}
+
+/*! opens and locks the lock file of the wisdom store, returns the file descriptor or -1*/
+static int lock_wisdom(int operation)
+{
+	char path[FILENAME_MAX];
+	int fd;
+
+	if(!cache_path(path, sizeof(path), "fftw.wisdom.lock")){ return -1; }
+
+	if( (fd = open(path, O_RDWR | O_CREAT, 0644)) < 0 ){
+		crusde_warning("(fft wisdom) cannot open %s: %s", path, strerror(errno));
+		return -1;
+	}
+
+	if(flock(fd, operation) != 0){
+		crusde_warning("(fft wisdom) cannot lock %s: %s", path, strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/*! releases the lock taken by lock_wisdom()*/
+static void unlock_wisdom(int fd)
+{
+	flock(fd, LOCK_UN);
+	close(fd);
+}
+
+/*! imports the wisdom file name in the cache directory with the given FFTW importer*/
+static void import_store(const char *name, int (*import)(const char*))
+{
+	char path[FILENAME_MAX];
+	int fd;
+
+	if(!cache_path(path, sizeof(path), name)){ return; }
+	if( (fd = lock_wisdom(LOCK_SH)) < 0 ){ return; }
+
+	if(access(path, R_OK) == 0){
+		if(import(path)){
+			crusde_info("(fft wisdom) imported %s", path);
+		}
+		else{
+			crusde_warning("(fft wisdom) could not read %s, ignoring it", path);
+		}
+	}
+
+	unlock_wisdom(fd);
+}
+
+/*! merges the wisdom file name in the cache directory into FFTW and replaces it by all wisdom FFTW has*/
+static void export_store(const char *name, int (*import)(const char*), int (*export)(const char*))
+{
+	char path[FILENAME_MAX];
+	char temp[FILENAME_MAX+16];
+	int fd;
+
+	if(!cache_path(path, sizeof(path), name)){ return; }
+	if( (fd = lock_wisdom(LOCK_EX)) < 0 ){ return; }
+
+	if(access(path, R_OK) == 0){
+		import(path);
+	}
+
+	snprintf(temp, sizeof(temp), "%s.%d", path, (int) getpid());
+
+	if(export(temp) && rename(temp, path) == 0){
+		crusde_info("(fft wisdom) exported %s", path);
+	}
+	else{
+		crusde_warning("(fft wisdom) could not write %s", path);
+		remove(temp);
+	}
+
+	unlock_wisdom(fd);
+}
+
+//! Imports the wisdom store into FFTW, call before creating plans
+void fft_import_wisdom()
+{
+	import_store("fftw.wisdom",  fftw_import_wisdom_from_filename);
+	import_store("fftwf.wisdom", fftwf_import_wisdom_from_filename);
+}
+
+//! Merges the wisdom gathered while planning into the wisdom store, call after creating plans
+/*!
+ * Under an exclusive lock the store is imported again (it might have been extended by another
+ * process since fft_import_wisdom()), all wisdom is written to a temporary file which then
+ * replaces the store, so readers never see a partially written file. Double and single 
+ * precision wisdom are kept in separate files.
+ */
+void fft_export_wisdom()
+{
+	export_store("fftw.wisdom",  fftw_import_wisdom_from_filename,  fftw_export_wisdom_to_filename);
+	export_store("fftwf.wisdom", fftwf_import_wisdom_from_filename, fftwf_export_wisdom_to_filename);
+}
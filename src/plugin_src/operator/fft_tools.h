@@ -0,0 +1,55 @@
+/***************************************************************************
+ * File:        ./plugins/operator/fft_tools.h
+ * Author:      agent
+ * Created:     17.10.2026
+ * Licence:     GPL
+ ****************************************************************************/
+
+/**
+ *  @ingroup Operator
+ */
+ /*@{*/
+/** \file fft_tools.h
+ *
+ * Helper functions shared by the FFTW based operator plugins: transform sizes, planner
+ * rigor, threads, persistent FFTW wisdom, the support of truncated Green's functions and their symmetry. This is not a plugin, the object file is linked into
+ * each operator library (see Makefile).
+ */
+/*@}*/
+
+#ifndef _fft_tools_h
+#define _fft_tools_h
+
+/* smallest length >= n that factors into 2, 3, 5 and 7 only */
+int	fft_smooth_size(int n);
+
+/* benchmarks a few smooth lengths >= n and returns the fastest one */
+int	fft_tune_size_1d(int n, unsigned flags);
+
+/* benchmarks a few smooth sizes >= (n_x, n_y) for a 2D transform, results go to *N_X, *N_Y */
+void	fft_tune_size_2d(int n_x, int n_y, unsigned flags, int *N_X, int *N_Y);
+
+/* radius of the Green's function support in grid cells from a radius in meters or a relative */
+/* tolerance (radius 0), -1: no truncation */
+int	fft_kernel_radius(double radius, double tolerance, int max_offset);
+
+/* signs that mirror first quadrant Green's function values to quadrant 1-4, 0: no symmetry */
+int	fft_mirror_signs(int quadrant, double *sign);
+
+/* points evaluated per call of crusde_get_green_row_at() */
+#define FFT_ROW_CHUNK 64
+
+/* n Green's function values at (x ... x+n-1, y) with a workspace, interleaved to value[i*stride + d] */
+void	fft_green_row(void *workspace, double *value, int stride, int x, int y, int n, int quadrant);
+
+/* FFTW planner flags for 'estimate', 'measure' or 'patient' */
+unsigned fft_planner_flags(const char *rigor);
+
+/* number of threads to use (requested <= 0: available cores), sets up threaded FFTW planning */
+int	fft_init_threads(double requested);
+
+/* read / merge and write the wisdom store in $CRUSDE_HOME/cache */
+void	fft_import_wisdom();
+void	fft_export_wisdom();
+
+#endif // _fft_tools_h
@@ -0,0 +1,666 @@
+/***************************************************************************
+ * File:        ./plugins/operator/hankel_conv.c
+ * Author:      agent
+ * Created:     17.10.2026
+ * Licence:     GPL
+ ****************************************************************************/
+
+/**
+ *  @ingroup Operator
+ */
+ /*@{*/
+/** \file hankel_conv.c
+ *
+ * Implements the convolution of an axisymmetric load with an axisymmetric Green's function
+ * (see crusde_get_green_symmetry()) as a product of Hankel transforms in radius. With the
+ * transform H_nu[f](k) = int f(r) J_nu(kr) r dr, which is its own inverse, the vertical and
+ * the radial displacement of a load l(r) are
+ *
+ *	u_z = 2 pi H_0[ H_0[l] H_0[g_z] ],	u_r = 2 pi H_1[ H_0[l] H_1[g_r] ],
+ *
+ * g_z and g_r being the vertical and radial displacement of the Green's function. The
+ * transforms are done with FFTLog (Hamilton, 2000, MNRAS 312, 257): on a grid uniform in
+ * ln r the Hankel transform is a convolution, i.e. two 1D DFTs of the length of the grid.
+ * For an n x n region this is O(n log n) instead of the O(n^2 log n) of a 2D DFT, the
+ * mapping of the radial result onto the region costs O(n^2) as any output does.
+ *
+ * The load is the azimuthal average of the load function around its center, which is
+ * given or the centroid of the absolute load, and must lie within the region. A load that deviates from its average by more than
+ * symmetry_tolerance is refused. The Green's function is sampled along the x-axis in grid
+ * cell steps and interpolated. Unlike the grid convolution of 'fast 2d convolution' the
+ * singularity of a Green's function at r = 0 is integrated, the results differ within
+ * the load, most at its edge.
+ */
+/*@}*/
+
+#include <complex.h>
+#include <fftw3.h>
+#include "crusde_api.h"
+#include "fft_tools.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define RESET(x,y) (x = y = -1)
+/* ends of the logarithmic grid: in grid cells, and in multiples of the largest distance within the region; */
+/* the transforms alias their values beyond both ends, the wide range lets them decay to a relative 1e-5 */
+#define R_MIN_CELLS 1.0e-8
+#define R_MAX_REACH 128.0
+/* below this radius, in grid cells, the unbiased transforms ring; the displacement is taken from there */
+#define R_NEAR_CELLS 1.0e-3
+
+/**
+ * Coefficients of the Hankel transform of order nu on the logarithmic grid: the DFT of the kernel
+ * (kr)^q J_nu(kr) in ln(kr), scaled by 1/N and shifted to the output grid. The power law bias q
+ * makes the transformed function and its transform decay at both ends of the grid.
+ */
+typedef struct s_hankel_kernel
+{
+	double nu;			/*order of the Bessel function*/
+	double q;			/*power law bias*/
+	fftw_complex *u;		/*N/2+1 coefficients*/
+} hankel_kernel;
+
+/*variables*/
+/* N: length of the logarithmic grid, r_grid[n] = r_min exp(n dlnr), k_grid[n] = 1/r_grid[N-1-n] */
+int N;
+double dlnr;
+double *r_grid, *k_grid;
+
+/* buffers and plans of the DFTs, the transforms are out-of-place */
+double       *samples;
+fftw_complex *spectrum;
+fftw_plan     forward_plan, backward_plan;
+
+hankel_kernel load_kernel;		/*H_0 of the load*/
+hankel_kernel green_kernel[2];		/*H_0 of g_z, H_1 of g_r*/
+hankel_kernel result_kernel[2];		/*H_0 and H_1 back to radius*/
+
+double *load_profile, *load_spectrum;	/*load per unit area on r_grid and its transform on k_grid*/
+double *green_spectrum[2];		/*H_0[g_z] and H_1[g_r] on k_grid*/
+double *product, *displacement[2];	/*product of the spectra, u_z and u_r on r_grid*/
+double *green_radial[2];		/*r g_z and r g_r at integer grid cells*/
+double *ring_sum, *ring_radius;		/*sums of the load and of radii per ring of one grid cell width*/
+int    *ring_count;
+int     rings;
+
+char   *green_job = NULL;		/*job the Green's function spectra were computed for*/
+int     green_samples;			/*green_radial holds samples 0 ... green_samples-1*/
+double  green_reach;			/*largest distance between two points of the region in m*/
+
+double      **result;
+double       *load_grid, *green_back;
+
+int size_x, size_y, gridsize;
+int x=-1, y=-1, n=-1;
+int dimensions=1;
+int displacement_dimensions=1;
+int x_index=-1, y_index=-1, z_index=-1;
+
+double *p_center_x;		/*center of the load, Lambert coordinate in m within the region, default: centroid of the absolute load*/
+double *p_center_y;
+double *p_symmetry_tolerance;	/*largest deviation of the load from its azimuthal average, relative, 0: no check*/
+double *p_oversampling;		/*points of the logarithmic grid per grid cell at the largest distance in the region*/
+
+boolean is_initialized = false;
+
+/* plugin interface */
+extern void register_output_fields();
+extern void register_parameter();
+extern void request_plugins();
+extern void init();
+extern void clear();
+extern void run();
+
+extern const char* get_name() 	 { return "hankel 2d convolution"; }
+extern const char* get_version() { return "0.1"; }
+extern const char* get_authors() { return "agent"; }
+extern const char* get_description() { return "Performs the 2D-convolution of an axisymmetric load and an axisymmetric \
+    Green's function as Hankel transforms in radius (FFTLog, based on FFTW3, http://www.fftw.org), which costs \
+    O(n log n) for n grid cells along an axis. The center of the load is given (center_x, center_y) or the centroid of the absolute load, it must lie within the region. \
+    <br /><br /> \
+    NOTE: This plug-in will treat only one load function, which must be axisymmetric, e.g. one 'disk load'.";
+}
+extern PluginCategory get_category() { return KERNEL_PLUGIN; }
+/*!empty*/
+extern void request_plugins(){}
+/*!empty*/
+extern void register_output_fields(){}
+
+/******************************************************************/
+/***IMPLEMENTATION*************************************************/
+/******************************************************************/
+
+//! Register parameters this Kernel claims from the input.
+/*! This plugin calls register_kernel_param() defined in crusde_api.h to register
+ *  references to parameters this Kernel will need to operate properly.
+ *  For command line use the order of registration in this function defines the
+ *  identification of parameters in the command line string (i.e. './green -KfirstRegistered/secondRegistered/...').
+ *  In case an XML is used to configure the experiment, the reference to this parameter will be identified by
+ *  the string passed as second argument to register_kernel_param().
+ *
+ *  This function registers the references in the following order:
+ *	-# center_x	(optional, center of the load, Lambert coordinate in m within the region, default: centroid of the absolute load)
+ *	-# center_y	(optional, center of the load, Lambert coordinate in m within the region, default: centroid of the absolute load)
+ *	-# symmetry_tolerance	(optional, largest relative deviation of the load from its azimuthal average, default: 0.5, 0: no check)
+ *	-# oversampling	(optional, points of the radial grid per grid cell at the largest distance, default: 4)
+ *
+ *  Thus, the command line parameter string is: <tt>-K</tt>
+ *
+ *  @see register_kernel_param()
+ *  @see register_parameter() (temp_plugin.c.tmp)
+ */
+extern void register_parameter(){
+   /* tell main program about parameters we claim from input */
+   p_center_x = crusde_register_optional_param_double("center_x", get_category(), NAN);
+   p_center_y = crusde_register_optional_param_double("center_y", get_category(), NAN);
+   p_symmetry_tolerance = crusde_register_optional_param_double("symmetry_tolerance", get_category(), 0.5);
+   p_oversampling       = crusde_register_optional_param_double("oversampling", get_category(), 4.0);
+}
+
+//! Logarithm of the gamma function for complex arguments
+/*!
+ * The argument is shifted to Re z >= 10 with Gamma(z+1) = z Gamma(z), where the Stirling
+ * series is accurate to double precision. The branch of the logarithm is arbitrary, the
+ * result is only used as an exponent.
+ */
+static double complex log_gamma(double complex z)
+{
+   double complex shift = 0.0;
+   double complex w, w2;
+
+   while(creal(z) < 10.0){
+	shift += clog(z);
+	z += 1.0;
+   }
+
+   w  = 1.0/z;
+   w2 = w*w;
+
+   return (z-0.5)*clog(z) - z + 0.5*log(2.0*M_PI)
+          + w*(1.0/12.0 - w2*(1.0/360.0 - w2*(1.0/1260.0 - w2*(1.0/1680.0 - w2/1188.0)))) - shift;
+}
+
+//! Sets up the coefficients of the Hankel transform of order nu with bias q
+/*!
+ * The kernel (kr)^q J_nu(kr) has the Fourier transform in s = ln(kr)
+ *
+ *	U(w) = int t^(q+iw-1) J_nu(t) dt = 2^(q+iw-1) Gamma((nu+q+iw)/2) / Gamma((nu-q-iw)/2+1),
+ *
+ * which requires -nu < q < 3/2. The coefficient of frequency m is U(2 pi m/(N dlnr)), scaled by
+ * 1/N and by the phase that maps the result onto the reciprocal grid k_n = 1/r_(N-1-n).
+ */
+static void plan_kernel(hankel_kernel *h, double nu, double q)
+{
+   double complex z;
+   int m;
+
+   h->nu = nu;
+   h->q  = q;
+   h->u  = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * (N/2+1));
+
+   if(h->u == NULL){
+	crusde_bad_alloc();
+   }
+
+   for(m = 0; m <= N/2; ++m){
+	z = q + I * 2.0*M_PI*m / (N*dlnr);
+	h->u[m] = cexp( (z-1.0)*log(2.0) + log_gamma(0.5*(nu+z)) - log_gamma(0.5*(nu-z) + 1.0)
+	                + I * 2.0*M_PI*m*(N-1) / N ) / N;
+   }
+}
+
+//! Hankel transform of order h->nu of 'in', sampled on the radial grid (from_r) or the wavenumber grid
+/*!
+ * The biased input in x^(2-q) is transformed, multiplied with the kernel coefficients and
+ * transformed back. Both DFTs run in the same direction, which is a correlation in ln x, i.e.
+ * the Hankel transform, evaluated on the reciprocal grid; 'out' is unbiased by y^(-q).
+ */
+static void hankel_transform(hankel_kernel *h, const double *in, double *out, boolean from_r)
+{
+   const double *in_grid  = (from_r ? r_grid : k_grid);
+   const double *out_grid = (from_r ? k_grid : r_grid);
+   int m;
+
+   for(m = 0; m < N; ++m){
+	samples[m] = in[m] * pow(in_grid[m], 2.0 - h->q);
+   }
+
+   fftw_execute(forward_plan);
+
+   /* the result is real, the conjugate turns the backward DFT into a forward one */
+   for(m = 0; m <= N/2; ++m){
+	spectrum[m] = conj(spectrum[m] * h->u[m]);
+   }
+
+   fftw_execute(backward_plan);
+
+   for(m = 0; m < N; ++m){
+	out[m] = samples[m] * pow(out_grid[m], -h->q);
+   }
+}
+
+/*! r g(r) at r in m from the samples at integer grid cells, a cubic between the samples and linear below one grid cell*/
+static double green_at(const double *radial, double r)
+{
+   double t = r / gridsize;
+   double f0, f1, f2, f3;
+   int j = (int) floor(t);
+
+   if(j >= green_samples-2){
+	return 0.0;
+   }
+   if(t < 1.0){
+	return radial[1] + (t-1.0) * (radial[2] - radial[1]);
+   }
+
+   /* Catmull-Rom spline, the value at r = 0 is extrapolated linearly, r g(r) need not vanish there */
+   f0 = (j > 1 ? radial[j-1] : 2.0*radial[1] - radial[2]);
+   f1 = radial[j];
+   f2 = radial[j+1];
+   f3 = radial[j+2];
+   t -= j;
+
+   return f1 + 0.5*t*(f2 - f0 + t*(2.0*f0 - 5.0*f1 + 4.0*f2 - f3 + t*(3.0*(f1 - f2) + f3 - f0)));
+}
+
+//! Transforms the Green's function of the current job
+/*!
+ * g_z and g_r are taken along the positive x-axis in quadrant 1, where the x-component is the
+ * radial one, up to twice the largest distance within the region. Distances up to green_reach
+ * are those between two points of the region, beyond that the Green's function is tapered to
+ * 0 with a cosine, so its transform does not ring.
+ */
+static void transform_green()
+{
+   double r, taper;
+   int j, c;
+
+   crusde_info("(%s) Hankel transforms of the Green's function of job %s ...", get_name(), crusde_get_current_job());
+
+   crusde_set_quadrant(1);
+   for(j = 0; j < green_samples; ++j){
+	crusde_get_green_at(&green_back, j, 0);
+
+	green_radial[0][j] = (z_index >= 0 ? j * (double) gridsize * green_back[z_index] : 0.0);
+	green_radial[1][j] = (x_index >= 0 ? j * (double) gridsize * green_back[x_index] : 0.0);
+   }
+
+   for(c = 0; c < 2; ++c){
+	for(j = 0; j < N; ++j){
+		r     = r_grid[j];
+		taper = (r <= green_reach ? 1.0 : (r < 2.0*green_reach ? pow(cos(0.5*M_PI*(r/green_reach - 1.0)), 2) : 0.0));
+		product[j] = taper * green_at(green_radial[c], r) / r;
+	}
+
+	hankel_transform(&green_kernel[c], product, green_spectrum[c], true);
+   }
+
+   free(green_job);
+   green_job = strdup(crusde_get_current_job());
+
+   if(green_job == NULL){
+	crusde_bad_alloc();
+   }
+}
+
+//! Initialization of the convolution. Allocation of memory for inputs and outputs
+/**
+ * Sets up the logarithmic grid: it spans R_MIN_CELLS grid cells to R_MAX_REACH times the 
+ * largest distance within the region, with 'oversampling' points per grid cell at the largest distance,
+ * and has a length that factors into 2, 3, 5 and 7. The kernels of the five Hankel transforms
+ * and the FFTW plans are created, the Green's function is transformed on the first call of
+ * run() for a job: the Green's function is not initialized before the operator.
+ */
+extern void init(){
+   double r_min, r_max;
+
+   size_x = crusde_get_size_x(); // LONGITUDE
+   size_y = crusde_get_size_y(); // LATITUDE
+   gridsize = crusde_get_gridsize();
+
+   dimensions = crusde_get_dimensions();
+   displacement_dimensions = crusde_get_displacement_dimensions();
+   x_index = crusde_get_x_index();
+   y_index = crusde_get_y_index();
+   z_index = crusde_get_z_index();
+
+   if(*p_oversampling <= 0.0){
+	crusde_error("(%s) oversampling must be positive, got %g", get_name(), *p_oversampling);
+   }
+
+   /* the rings of load_profile_at() and the radial grid reach as far as the region's diagonal */
+   if( (!isnan(*p_center_x) && (*p_center_x < crusde_get_min_x() || *p_center_x > crusde_get_min_x() + (size_x-1)*gridsize)) ||
+       (!isnan(*p_center_y) && (*p_center_y < crusde_get_min_y() || *p_center_y > crusde_get_min_y() + (size_y-1)*gridsize)) ){
+	crusde_error("(%s) the load center (%g, %g) m lies outside the region, use 'fast 2d convolution'",
+	             get_name(), *p_center_x, *p_center_y);
+   }
+
+   green_reach   = gridsize * sqrt( (double) (size_x-1)*(size_x-1) + (double) (size_y-1)*(size_y-1) );
+   green_samples = (int) ceil(2.0*green_reach / gridsize) + 3;
+   rings         = (int) ceil(green_reach / gridsize) + 2;
+
+   /* the spacing in ln r gives gridsize/oversampling at the largest distance in the region, N is even */
+   r_min = R_MIN_CELLS * gridsize;
+   r_max = R_MAX_REACH * (green_reach > gridsize ? green_reach : gridsize);
+   N = fft_smooth_size( (int) ceil(log(r_max/r_min) * *p_oversampling * green_reach / gridsize) );
+   while(N % 2 != 0){
+	N = fft_smooth_size(N+1);
+   }
+   dlnr = log(r_max/r_min) / (N-1);
+
+   crusde_info("(%s) radial grid: %d points from %g m to %g m", get_name(), N, r_min, r_max);
+
+   /* the Green's function is sampled up to twice the largest distance along the x-axis */
+   crusde_set_operator_space(2*green_samples+1, 2*green_samples+1);
+
+/*------------------------------*/
+/*Allocation of Memory		*/
+/*------------------------------*/
+   r_grid        = (double*) malloc(sizeof(double) * N);
+   k_grid        = (double*) malloc(sizeof(double) * N);
+   load_profile  = (double*) malloc(sizeof(double) * N);
+   load_spectrum = (double*) malloc(sizeof(double) * N);
+   product       = (double*) malloc(sizeof(double) * N);
+   samples       = (double*) fftw_malloc(sizeof(double) * N);
+   spectrum      = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * (N/2+1));
+   load_grid     = (double*) malloc(sizeof(double) * size_x * size_y);
+   green_back    = (double*) malloc(sizeof(double) * displacement_dimensions);
+   ring_sum      = (double*) malloc(sizeof(double) * (rings+1));
+   ring_radius   = (double*) malloc(sizeof(double) * (rings+1));
+   ring_count    = (int*) malloc(sizeof(int) * rings);
+   result        = (double**) malloc(sizeof(double*) * dimensions);
+
+   if(r_grid == NULL || k_grid == NULL || load_profile == NULL || load_spectrum == NULL || product == NULL ||
+      samples == NULL || spectrum == NULL || load_grid == NULL || green_back == NULL || ring_sum == NULL ||
+      ring_radius == NULL || ring_count == NULL || result == NULL){
+	crusde_bad_alloc();
+   }
+
+   n=-1;
+   while(++n < 2){
+	green_spectrum[n] = (double*) malloc(sizeof(double) * N);
+	displacement[n]   = (double*) malloc(sizeof(double) * N);
+	green_radial[n]   = (double*) malloc(sizeof(double) * green_samples);
+
+	if(green_spectrum[n] == NULL || displacement[n] == NULL || green_radial[n] == NULL){
+		crusde_bad_alloc();
+	}
+   }
+
+   n=-1;
+   while(++n < dimensions){
+	result[n] = (double*) malloc(sizeof(double) * size_x * size_y);
+
+	if (result[n] == NULL){
+		crusde_bad_alloc();
+	}
+
+	x = -1;
+	while(++x < size_x * size_y){
+		result[n][x] = 0.0;
+	}
+   }
+
+   n=-1;
+   while(++n < N){
+	r_grid[n] = r_min * exp(n*dlnr);
+   }
+   n=-1;
+   while(++n < N){
+	k_grid[n] = 1.0 / r_grid[N-1-n];
+   }
+
+/*------------------------------*/
+/*Creation of Transform Plans	*/
+/*------------------------------*/
+   forward_plan  = fftw_plan_dft_r2c_1d(N, samples, spectrum, FFTW_ESTIMATE);
+   backward_plan = fftw_plan_dft_c2r_1d(N, spectrum, samples, FFTW_ESTIMATE);
+
+   /* biases within -nu < q < 3/2 that let the functions decay towards both ends of the grid */
+   plan_kernel(&load_kernel,      0.0, 0.75);
+   plan_kernel(&green_kernel[0],  0.0, 0.75);
+   plan_kernel(&green_kernel[1],  1.0, 0.5);
+   plan_kernel(&result_kernel[0], 0.0, 0.75);
+   plan_kernel(&result_kernel[1], 1.0, 0.5);
+
+   is_initialized = true;
+}
+
+/*! Frees memory allocated during init(). FFTW plans are destroyed.*/
+extern void clear(){
+   if(is_initialized)
+   {
+	   fftw_destroy_plan(forward_plan);
+	   fftw_destroy_plan(backward_plan);
+
+	   fftw_free(load_kernel.u);
+	   n=-1;
+	   while(++n < 2){
+		fftw_free(green_kernel[n].u);
+		fftw_free(result_kernel[n].u);
+		free(green_spectrum[n]);
+		free(displacement[n]);
+		free(green_radial[n]);
+	   }
+
+	   n=-1;
+	   while(++n < dimensions){
+		free(result[n]);
+	   }
+	   free(result);
+
+	   fftw_free(samples);
+	   fftw_free(spectrum);
+	   free(r_grid);
+	   free(k_grid);
+	   free(load_profile);
+	   free(load_spectrum);
+	   free(product);
+	   free(load_grid);
+	   free(green_back);
+	   free(ring_sum);
+	   free(ring_radius);
+	   free(ring_count);
+
+	   free(green_job);
+	   green_job = NULL;
+
+	   is_initialized = false;
+  }
+}
+
+//! Azimuthal average of the load around (center_x, center_y) on r_grid, per unit area
+/**
+ * The grid cells are put into rings of one grid cell width by their distance from the center.
+ * The average load per unit area of the cells of a ring is taken at their mean distance and
+ * interpolated linearly in between; one grid cell beyond the last ring the load is 0. Rings 
+ * that are cut by the border of the region are assumed to continue with the same average. 
+ * Returns the deviation of the load from the average of its ring, summed over all cells and 
+ * relative to the total absolute load. The center must lie within the region: no cell is farther
+ * from it than the region's diagonal, which the rings are allocated for in init().
+ */
+static double load_profile_at(double center_x, double center_y)
+{
+   double dx, dy, r, deviation = 0.0, total = 0.0;
+   int b, nodes, j;
+
+   for(b = 0; b < rings; ++b){
+	ring_sum[b]    = 0.0;
+	ring_radius[b] = 0.0;
+	ring_count[b]  = 0;
+   }
+
+   RESET(x,y);
+   while(++y < size_y){
+	x = -1;
+	while(++x < size_x){
+		dx = x*gridsize - center_x;
+		dy = y*gridsize - center_y;
+		r  = sqrt(dx*dx + dy*dy);
+		b  = (int) floor(r/gridsize + 0.5);
+
+		ring_sum[b]    += load_grid[x+size_x*y];
+		ring_radius[b] += r;
+		ring_count[b]  += 1;
+	}
+   }
+
+   /* deviation from the ring averages */
+   RESET(x,y);
+   while(++y < size_y){
+	x = -1;
+	while(++x < size_x){
+		dx = x*gridsize - center_x;
+		dy = y*gridsize - center_y;
+		b  = (int) floor(sqrt(dx*dx + dy*dy)/gridsize + 0.5);
+
+		deviation += fabs(load_grid[x+size_x*y] - ring_sum[b]/ring_count[b]);
+		total     += fabs(load_grid[x+size_x*y]);
+	}
+   }
+
+   /* the rings with cells become the nodes (ring_radius, ring_sum) of the interpolation, plus a 0 beyond */
+   nodes = 0;
+   for(b = 0; b < rings; ++b){
+	if(ring_count[b] > 0){
+		ring_radius[nodes] = ring_radius[b] / ring_count[b];
+		ring_sum[nodes]    = ring_sum[b] / ring_count[b] / ((double) gridsize*gridsize);
+		++nodes;
+	}
+   }
+   ring_radius[nodes] = ring_radius[nodes-1] + gridsize;
+   ring_sum[nodes]    = 0.0;
+
+   b = 0;
+   for(j = 0; j < N; ++j){
+	while(b <= nodes && ring_radius[b] < r_grid[j]){
+		++b;
+	}
+
+	if(b == 0){
+		load_profile[j] = ring_sum[0];
+	}
+	else if(b > nodes){
+		load_profile[j] = 0.0;
+	}
+	else{
+		load_profile[j] = ring_sum[b-1] + (r_grid[j] - ring_radius[b-1]) / (ring_radius[b] - ring_radius[b-1])
+		                                * (ring_sum[b] - ring_sum[b-1]);
+	}
+   }
+
+   return (total > 0.0 ? deviation / total : 0.0);
+}
+
+//! Performs the convolution
+/**
+ * Requests the load function values for the region of interest, takes the center of the load
+ * from center_x and center_y or as the centroid of the absolute load, which is defined also for
+ * a load of positive and negative parts that sum to 0, and its azimuthal average around
+ * it (see load_profile_at()). Stops if the load deviates from the average by more than
+ * symmetry_tolerance, use 'fast 2d convolution' then.
+ *
+ * The Hankel transforms of the Green's function are computed once per job (transform_green()).
+ * The transform of the load is multiplied with both and transformed back to u_z and u_r on the
+ * radial grid, which are interpolated linearly in ln r onto the region: u_x = u_r dx/r,
+ * u_y = u_r dy/r for the offset (dx,dy) of a point from the center.
+ */
+extern void run()
+{
+   double center_x, center_y, total, deviation, dx, dy, r, r_near, t, u_z, u_r;
+   int j;
+
+   if(crusde_get_green_symmetry() != AXIAL_SYMMETRY){
+	crusde_error("(%s) the Green's function of job %s is not axisymmetric, use 'fast 2d convolution'",
+	             get_name(), crusde_get_current_job());
+   }
+
+   if(green_job == NULL || strcmp(green_job, crusde_get_current_job()) != 0){
+	transform_green();
+   }
+
+   /* get the load, the thing that is time dependent ... */
+   total    = 0.0;
+   center_x = 0.0;
+   center_y = 0.0;
+
+   RESET(x,y);
+   while(++y < size_y){
+	x = -1;
+	while(++x < size_x){
+		load_grid[x+size_x*y] = crusde_get_load_at(x, y);
+
+		total    += fabs(load_grid[x+size_x*y]);
+		center_x += fabs(load_grid[x+size_x*y]) * x * gridsize;
+		center_y += fabs(load_grid[x+size_x*y]) * y * gridsize;
+	}
+   }
+
+   /* no load anywhere, no displacement */
+   if(total == 0.0){
+	n=-1;
+	while(++n < displacement_dimensions){
+		memset(result[n], 0, sizeof(double) * size_x * size_y);
+	}
+	crusde_set_result(result);
+	return;
+   }
+
+   center_x = (isnan(*p_center_x) ? center_x / total : *p_center_x - crusde_get_min_x());
+   center_y = (isnan(*p_center_y) ? center_y / total : *p_center_y - crusde_get_min_y());
+
+   deviation = load_profile_at(center_x, center_y);
+
+   crusde_info("(%s) load center (%g, %g) m, deviation from its azimuthal average %.3g", get_name(),
+               center_x + crusde_get_min_x(), center_y + crusde_get_min_y(), deviation);
+
+   if(*p_symmetry_tolerance > 0.0 && deviation > *p_symmetry_tolerance){
+	crusde_error("(%s) the load deviates from its azimuthal average by %.3g > symmetry_tolerance %g, use 'fast 2d convolution'",
+	             get_name(), deviation, *p_symmetry_tolerance);
+   }
+
+   crusde_info("(%s) Hankel transforms of load and displacement ...", get_name());
+
+   hankel_transform(&load_kernel, load_profile, load_spectrum, true);
+
+   for(n = 0; n < 2; ++n){
+	for(j = 0; j < N; ++j){
+		product[j] = 2.0*M_PI * load_spectrum[j] * green_spectrum[n][j];
+	}
+	hankel_transform(&result_kernel[n], product, displacement[n], false);
+   }
+
+   /* onto the region, linear in ln r, u_z is constant and u_r vanishes linearly towards r = 0 */
+   r_near = R_NEAR_CELLS * gridsize;
+   RESET(x,y);
+   while(++y < size_y){
+	x = -1;
+	while(++x < size_x){
+		dx = x*gridsize - center_x;
+		dy = y*gridsize - center_y;
+		r  = sqrt(dx*dx + dy*dy);
+
+		t = log( (r > r_near ? r : r_near) / r_grid[0] ) / dlnr;
+		j = (int) t;
+		if(j > N-2){ j = N-2; }
+		t -= j;
+		u_z = (1.0-t) * displacement[0][j] + t * displacement[0][j+1];
+		u_r = (1.0-t) * displacement[1][j] + t * displacement[1][j+1];
+
+		if(r < r_near){
+			u_r *= r / r_near;
+		}
+
+		if(z_index >= 0) result[z_index][x+size_x*y] = u_z;
+		if(x_index >= 0) result[x_index][x+size_x*y] = (r > 0.0 ? u_r * dx / r : 0.0);
+		if(y_index >= 0) result[y_index][x+size_x*y] = (r > 0.0 ? u_r * dy / r : 0.0);
+	}
+   }
+
+   /* give result to main application */
+   crusde_set_result(result);
+}